@@ -0,0 +1,243 @@
+#include "ApiRequestEngine.h"
+#include "CurlConnectionPool.h"
+#include "Tracing.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+
+// --- CONSTANTS ---
+const int MULTI_POLL_TIMEOUT_MS = 1000; // Upper bound on how long the loop sleeps without a wakeup
+
+/**
+ * @brief Callback function for libcurl to write received data into a std::string.
+ */
+static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    ((std::string *)userp)->append((char *)contents, size * nmemb);
+    return size * nmemb;
+}
+
+// Host part of "https://host:port/path"
+static std::string hostOf(const std::string& url)
+{
+    std::string::size_type start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    std::string::size_type end = url.find_first_of(":/", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// Turns libcurl's cumulative timers (all measured from the start of the transfer) into phase durations
+static ApiTiming readTiming(CURL *handle)
+{
+    curl_off_t nameLookup = 0, connect = 0, appConnect = 0, preTransfer = 0, startTransfer = 0, total = 0;
+    curl_off_t down = 0, up = 0;
+    long connects = 0;
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(handle, CURLINFO_PRETRANSFER_TIME_T, &preTransfer);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &down);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD_T, &up);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+
+    ApiTiming timing;
+    timing.newConnection = connects > 0;
+    timing.dnsUs = nameLookup;
+    timing.connectUs = (connect > 0) ? connect - nameLookup : 0;
+    timing.tlsUs = (appConnect > 0) ? appConnect - connect : 0;
+    timing.serverUs = (startTransfer > 0) ? startTransfer - preTransfer : 0;
+    timing.transferUs = (startTransfer > 0) ? total - startTransfer : 0;
+    timing.totalUs = total;
+    timing.bytesDown = down;
+    timing.bytesUp = up;
+    return timing;
+}
+
+ApiRequestEngine::ApiRequestEngine(QObject *parent)
+    : QObject(parent)
+{
+    multi = curl_multi_init();
+
+    networkThread = QThread::create([this]() { runLoop(); });
+    networkThread->setObjectName("ProxmoxNetwork");
+    networkThread->start();
+
+    // Our owner may outlive a.exec(); stop the thread before main() tears down
+    // the connection pool and libcurl. Owners living on another thread should
+    // stop that thread on aboutToQuit too, as this connection is then queued.
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                this, &ApiRequestEngine::shutdown);
+    }
+}
+
+ApiRequestEngine::~ApiRequestEngine()
+{
+    shutdown();
+}
+
+void ApiRequestEngine::shutdown()
+{
+    if (!networkThread) return;
+
+    stopRequested = true;
+    curl_multi_wakeup(multi);
+    networkThread->wait();
+    delete networkThread;
+    networkThread = nullptr;
+
+    // Anything submitted after the loop exited is failed back to the caller
+    QMutexLocker locker(&pendingMutex);
+    for (Transfer *transfer : pending) {
+        transfer->response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+        deliver(transfer);
+    }
+    pending.clear();
+
+    curl_multi_cleanup(multi);
+    multi = nullptr;
+}
+
+// --- SUBMISSION (any thread) ---
+
+void ApiRequestEngine::submit(const ApiRequest& request, QObject *context, Callback callback)
+{
+    Transfer *transfer = new Transfer;
+    transfer->request = request;
+    transfer->context = context;
+    transfer->callback = std::move(callback);
+
+    QMutexLocker locker(&pendingMutex);
+    if (stopRequested) {
+        qWarning() << "Request engine is shut down; dropping request for" << QString::fromStdString(request.url);
+        transfer->response.curlCode = CURLE_ABORTED_BY_CALLBACK;
+        deliver(transfer);
+        return;
+    }
+    pending.push_back(transfer);
+    PVE_TRACE_EVENT("ApiRequestEngine::submit", static_cast<qint64>(pending.size()), 0);
+    curl_multi_wakeup(multi);
+}
+
+// --- NETWORK THREAD ---
+
+void ApiRequestEngine::runLoop()
+{
+    while (!stopRequested) {
+        startPendingTransfers();
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *msg;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            Transfer *transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            CURLcode result = msg->data.result;
+            if (transfer) finishTransfer(transfer, result);
+        }
+
+        curl_multi_poll(multi, nullptr, 0, MULTI_POLL_TIMEOUT_MS, nullptr);
+    }
+
+    // Abort whatever is still running
+    for (Transfer *transfer : std::vector<Transfer*>(active)) {
+        finishTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+}
+
+void ApiRequestEngine::startPendingTransfers()
+{
+    std::vector<Transfer*> batch;
+    {
+        QMutexLocker locker(&pendingMutex);
+        batch.swap(pending);
+    }
+
+    for (Transfer *transfer : batch) {
+        CURL *curl = CurlConnectionPool::instance().acquire();
+        if (!curl) {
+            transfer->response.curlCode = CURLE_FAILED_INIT;
+            deliver(transfer);
+            continue;
+        }
+        transfer->handle = curl;
+
+        const ApiRequest& req = transfer->request;
+        curl_easy_setopt(curl, CURLOPT_URL, req.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response.body);
+
+        if (req.method == ApiRequest::Method::Post) {
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.postFields.c_str());
+        }
+
+        if (req.timeoutMs > 0) {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, req.timeoutMs);
+        }
+
+        if (!req.verifySsl) {
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        }
+
+        for (const std::string& header : req.headers) {
+            transfer->headerList = curl_slist_append(transfer->headerList, header.c_str());
+        }
+        if (transfer->headerList) {
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headerList);
+        }
+
+        curl_multi_add_handle(multi, curl);
+        active.push_back(transfer);
+    }
+}
+
+void ApiRequestEngine::finishTransfer(Transfer *transfer, CURLcode result)
+{
+    transfer->response.curlCode = result;
+    curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &transfer->response.httpCode);
+    transfer->response.timing = readTiming(transfer->handle);
+    requestMetrics.record(hostOf(transfer->request.url), transfer->request.metricsLabel, transfer->response.timing,
+                          result != CURLE_OK, transfer->response.httpCode);
+
+    curl_multi_remove_handle(multi, transfer->handle);
+    curl_slist_free_all(transfer->headerList);
+    transfer->headerList = nullptr;
+    CurlConnectionPool::instance().release(transfer->handle);
+    transfer->handle = nullptr;
+
+    active.erase(std::remove(active.begin(), active.end(), transfer), active.end());
+    PVE_TRACE_EVENT("ApiRequestEngine::finish", transfer->response.httpCode, transfer->response.curlCode);
+    qCDebug(lcNetwork) << "Finished" << QString::fromStdString(transfer->request.url)
+                       << "HTTP" << transfer->response.httpCode << "curl" << transfer->response.curlCode
+                       << "total" << transfer->response.timing.totalUs << "us (dns" << transfer->response.timing.dnsUs
+                       << "connect" << transfer->response.timing.connectUs << "tls" << transfer->response.timing.tlsUs
+                       << "server" << transfer->response.timing.serverUs << "transfer" << transfer->response.timing.transferUs << ")";
+    deliver(transfer);
+}
+
+/**
+ * @brief Hands the result to the caller's thread and frees the transfer there.
+ */
+void ApiRequestEngine::deliver(Transfer *transfer)
+{
+    // No liveness check here: 'context' belongs to another thread, so any check would race
+    // with its destruction. Qt discards queued calls whose receiver has been deleted.
+    QObject *context = transfer->context;
+    ApiResponse response = std::move(transfer->response);
+    Callback callback = std::move(transfer->callback);
+    delete transfer;
+
+    QMetaObject::invokeMethod(context, [callback, response]() {
+        if (callback) callback(response);
+    }, Qt::QueuedConnection);
+}
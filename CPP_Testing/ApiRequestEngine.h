@@ -0,0 +1,90 @@
+#ifndef APIREQUESTENGINE_H
+#define APIREQUESTENGINE_H
+
+#include <QObject>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "RequestMetrics.h"
+
+// --- REQUEST / RESPONSE DATA ---
+struct ApiRequest
+{
+    enum class Method { Get, Post };
+
+    Method method = Method::Get;
+    std::string url;                  // Full URL, e.g. https://host:8006/api2/json/cluster/resources
+    std::string postFields;           // Body for POST requests (may be empty)
+    std::vector<std::string> headers; // Raw "Name: value" header lines
+    bool verifySsl = false;
+    long timeoutMs = 0;               // Whole-transfer timeout; 0 means none
+    std::string metricsLabel = "api"; // Groups the request's timings in RequestMetrics
+};
+
+struct ApiResponse
+{
+    CURLcode curlCode = CURLE_OK;
+    long httpCode = 0;
+    std::string body;
+    ApiTiming timing;                 // Phase breakdown as measured by curl
+
+    bool ok() const { return curlCode == CURLE_OK && httpCode == 200; }
+};
+
+// --- ApiRequestEngine ---
+// Runs every HTTP transfer on a dedicated network thread driven by a curl multi handle.
+// submit() is thread-safe and never blocks; the callback is invoked through a queued
+// call in the thread of the supplied context object (normally the caller's thread).
+class ApiRequestEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void(const ApiResponse&)>;
+
+    explicit ApiRequestEngine(QObject *parent = nullptr);
+    ~ApiRequestEngine() override;
+
+    // Queues a request. 'context' must outlive the network thread (its owner calls shutdown()
+    // first); a callback already queued to it is dropped by Qt if it is destroyed meanwhile.
+    void submit(const ApiRequest& request, QObject *context, Callback callback);
+
+    // Timing histograms of every finished transfer, per endpoint (thread-safe)
+    RequestMetrics& metrics() { return requestMetrics; }
+
+public slots:
+    // Stops the network thread; transfers still in flight are aborted. Safe to call twice.
+    void shutdown();
+
+private:
+    struct Transfer
+    {
+        ApiRequest request;
+        ApiResponse response;
+        QObject *context = nullptr;
+        Callback callback;
+        CURL *handle = nullptr;
+        struct curl_slist *headerList = nullptr;
+    };
+
+    void runLoop();
+    void startPendingTransfers();
+    void finishTransfer(Transfer *transfer, CURLcode result);
+    static void deliver(Transfer *transfer);
+
+    CURLM *multi = nullptr;
+    QThread *networkThread = nullptr;
+    std::atomic<bool> stopRequested{false};
+
+    QMutex pendingMutex;
+    std::vector<Transfer*> pending;   // Submitted, not yet added to the multi handle (guarded)
+    std::vector<Transfer*> active;    // Owned by the network thread only
+
+    RequestMetrics requestMetrics;
+};
+
+#endif // APIREQUESTENGINE_H
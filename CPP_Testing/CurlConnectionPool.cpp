@@ -0,0 +1,160 @@
+#include "CurlConnectionPool.h"
+#include <sstream>
+#include <iomanip>
+
+// --- CONSTANTS ---
+const size_t MAX_IDLE_HANDLES = 16;     // Extra handles beyond this are freed on release
+const long TCP_KEEPALIVE_IDLE_SEC = 30; // Keep idle pveproxy connections from being dropped by NAT
+
+CurlConnectionPool& CurlConnectionPool::instance()
+{
+    static CurlConnectionPool pool;
+    return pool;
+}
+
+CurlConnectionPool::CurlConnectionPool()
+{
+    share = curl_share_init();
+    if (share) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &CurlConnectionPool::lockCallback);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &CurlConnectionPool::unlockCallback);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+}
+
+CurlConnectionPool::~CurlConnectionPool()
+{
+    // Normally already done by main() before curl_global_cleanup
+    shutdown();
+}
+
+void CurlConnectionPool::shutdown()
+{
+    std::lock_guard<std::mutex> guard(idleMutex);
+    if (isShutdown) return;
+    isShutdown = true;
+
+    for (CURL* handle : idleHandles) {
+        curl_easy_cleanup(handle);
+    }
+    idleHandles.clear();
+
+    if (share) {
+        curl_share_cleanup(share);
+        share = nullptr;
+    }
+}
+
+// --- SHARE LOCKING ---
+
+void CurlConnectionPool::lockCallback(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp)
+{
+    (void)handle;
+    (void)access;
+    static_cast<CurlConnectionPool*>(userp)->shareLocks[data].lock();
+}
+
+void CurlConnectionPool::unlockCallback(CURL* handle, curl_lock_data data, void* userp)
+{
+    (void)handle;
+    static_cast<CurlConnectionPool*>(userp)->shareLocks[data].unlock();
+}
+
+// --- HANDLE LIFECYCLE ---
+
+/**
+ * @brief Applies the options every pooled handle needs. curl_easy_reset clears
+ * the share pointer too, so this runs on every acquire.
+ */
+void CurlConnectionPool::applyDefaults(CURL* handle)
+{
+    if (share) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, share);
+    }
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, TCP_KEEPALIVE_IDLE_SEC);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, TCP_KEEPALIVE_IDLE_SEC);
+}
+
+CURL* CurlConnectionPool::acquire()
+{
+    CURL* handle = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(idleMutex);
+        if (!idleHandles.empty()) {
+            handle = idleHandles.back();
+            idleHandles.pop_back();
+        }
+    }
+
+    if (handle) {
+        curl_easy_reset(handle);
+    } else {
+        handle = curl_easy_init();
+        if (!handle) return nullptr;
+        handlesCreatedCount++;
+    }
+
+    applyDefaults(handle);
+    return handle;
+}
+
+void CurlConnectionPool::recordTransfer(CURL* handle)
+{
+    long connects = 0;
+    curl_off_t appconnect_us = 0;
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appconnect_us);
+
+    requestCount++;
+    if (connects > 0) {
+        newConnectionCount++;
+        if (appconnect_us > 0) tlsHandshakeCount++;
+    } else {
+        reusedConnectionCount++;
+    }
+}
+
+void CurlConnectionPool::release(CURL* handle)
+{
+    if (!handle) return;
+    recordTransfer(handle);
+
+    {
+        std::lock_guard<std::mutex> guard(idleMutex);
+        if (!isShutdown && idleHandles.size() < MAX_IDLE_HANDLES) {
+            idleHandles.push_back(handle);
+            return;
+        }
+    }
+    curl_easy_cleanup(handle);
+}
+
+// --- STATISTICS ---
+
+CurlConnectionPool::Stats CurlConnectionPool::stats() const
+{
+    Stats s;
+    s.requests = requestCount.load();
+    s.newConnections = newConnectionCount.load();
+    s.reusedConnections = reusedConnectionCount.load();
+    s.tlsHandshakes = tlsHandshakeCount.load();
+    s.handlesCreated = handlesCreatedCount.load();
+    return s;
+}
+
+std::string CurlConnectionPool::statsSummary() const
+{
+    Stats s = stats();
+    std::ostringstream out;
+    out << s.requests << " requests, "
+        << s.newConnections << " new connections (" << s.tlsHandshakes << " TLS handshakes), "
+        << s.reusedConnections << " reused ("
+        << std::fixed << std::setprecision(1) << (s.reuseRatio() * 100.0) << "% reuse), "
+        << s.handlesCreated << " handles created";
+    return out.str();
+}
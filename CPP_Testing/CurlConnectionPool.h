@@ -0,0 +1,73 @@
+#ifndef CURLCONNECTIONPOOL_H
+#define CURLCONNECTIONPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+
+// --- CurlConnectionPool ---
+// Process-wide pool of reusable CURL easy handles. Every handle is attached to a
+// single CURLSH share object so DNS entries, TLS sessions and live connections to
+// pveproxy are reused across requests instead of paying a TCP + TLS handshake each time.
+class CurlConnectionPool
+{
+public:
+    // Snapshot of the reuse counters (all values are totals since startup)
+    struct Stats
+    {
+        std::uint64_t requests = 0;          // Transfers that went through the pool
+        std::uint64_t newConnections = 0;    // Transfers that had to open a TCP connection
+        std::uint64_t reusedConnections = 0; // Transfers served on an already-open connection
+        std::uint64_t tlsHandshakes = 0;     // New connections that performed a TLS handshake
+        std::uint64_t handlesCreated = 0;    // curl_easy_init calls made by the pool
+
+        double reuseRatio() const {
+            return requests ? static_cast<double>(reusedConnections) / requests : 0.0;
+        }
+    };
+
+    // Global instance. curl_global_init must have been called before first use.
+    static CurlConnectionPool& instance();
+
+    // Returns a reset handle with the shared defaults (share, keep-alive, SSL options) applied.
+    CURL* acquire();
+
+    // Records the transfer statistics of a finished handle and returns it to the idle list.
+    void release(CURL* handle);
+
+    Stats stats() const;
+    std::string statsSummary() const;
+
+    // Frees all idle handles and the share object. Call before curl_global_cleanup.
+    void shutdown();
+
+private:
+    CurlConnectionPool();
+    ~CurlConnectionPool();
+    CurlConnectionPool(const CurlConnectionPool&) = delete;
+    CurlConnectionPool& operator=(const CurlConnectionPool&) = delete;
+
+    void applyDefaults(CURL* handle);
+    void recordTransfer(CURL* handle);
+
+    static void lockCallback(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void unlockCallback(CURL* handle, curl_lock_data data, void* userp);
+
+    CURLSH* share = nullptr;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+    mutable std::mutex idleMutex;
+    std::vector<CURL*> idleHandles;
+    bool isShutdown = false;
+
+    std::atomic<std::uint64_t> requestCount{0};
+    std::atomic<std::uint64_t> newConnectionCount{0};
+    std::atomic<std::uint64_t> reusedConnectionCount{0};
+    std::atomic<std::uint64_t> tlsHandshakeCount{0};
+    std::atomic<std::uint64_t> handlesCreatedCount{0};
+};
+
+#endif // CURLCONNECTIONPOOL_H
@@ -0,0 +1,129 @@
+#include "DiagnosticsPanel.h"
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFile>
+#include <QFileInfo>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// --- CONSTANTS ---
+const int METRICS_REFRESH_MS = 1000;
+const char *METRICS_DUMP_FILE = "request_metrics.json";
+
+DiagnosticsPanel::DiagnosticsPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    selectionLabel = new QLabel("Not connected.");
+    selectionLabel->setWordWrap(true);
+
+    endpointTable = new QTableWidget(0, 6);
+    endpointTable->setHorizontalHeaderLabels({"Endpoint", "State", "RTT (ms)", "Requests", "Failures", "Last error"});
+    endpointTable->setEditTriggers(QTableWidget::NoEditTriggers);
+    endpointTable->setSelectionMode(QAbstractItemView::NoSelection);
+    endpointTable->horizontalHeader()->setStretchLastSection(true);
+
+    // Request timing: one row per endpoint/label/phase, in milliseconds
+    timingTable = new QTableWidget(0, 8);
+    timingTable->setHorizontalHeaderLabels({"Endpoint", "Kind", "Phase", "Count", "p50", "p90", "p99", "Max"});
+    timingTable->setEditTriggers(QTableWidget::NoEditTriggers);
+    timingTable->setSelectionMode(QAbstractItemView::NoSelection);
+    timingTable->horizontalHeader()->setStretchLastSection(true);
+
+    metricsLabel = new QLabel("No requests yet.");
+    saveJsonButton = new QPushButton("Save JSON");
+    connect(saveJsonButton, &QPushButton::clicked, this, &DiagnosticsPanel::saveMetricsJson);
+
+    QHBoxLayout *metricsHeader = new QHBoxLayout;
+    metricsHeader->addWidget(new QLabel("Request timing (ms)"));
+    metricsHeader->addStretch(1);
+    metricsHeader->addWidget(saveJsonButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(new QLabel("API endpoints"));
+    layout->addWidget(selectionLabel);
+    layout->addWidget(endpointTable);
+    layout->addLayout(metricsHeader);
+    layout->addWidget(metricsLabel);
+    layout->addWidget(timingTable);
+
+    // Only poll while someone is looking
+    refreshTimer.setInterval(METRICS_REFRESH_MS);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() {
+        if (isVisible()) emit metricsRequested();
+    });
+    refreshTimer.start();
+}
+
+void DiagnosticsPanel::setRequestMetrics(const QString& jsonText)
+{
+    lastMetricsJson = jsonText;
+
+    json metrics = json::parse(jsonText.toStdString(), nullptr, false);
+    if (metrics.is_discarded() || !metrics.contains("endpoints")) return;
+
+    auto ms = [](const json& value) { return QString::number(value.get<double>() / 1000.0, 'f', 1); };
+
+    int row = 0;
+    quint64 requests = 0, errors = 0;
+    timingTable->setRowCount(0);
+    for (const json& endpoint : metrics["endpoints"]) {
+        requests += endpoint.value("requests", 0ULL);
+        errors += endpoint.value("transportErrors", 0ULL);
+        for (const char *phase : {"dns", "connect", "tls", "server", "transfer", "total"}) {
+            const json& histogram = endpoint["phases"][phase];
+            if (histogram.value("count", 0ULL) == 0) continue;
+
+            timingTable->setRowCount(row + 1);
+            timingTable->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(endpoint.value("host", ""))));
+            timingTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(endpoint.value("label", ""))));
+            timingTable->setItem(row, 2, new QTableWidgetItem(phase));
+            timingTable->setItem(row, 3, new QTableWidgetItem(QString::number(histogram["count"].get<quint64>())));
+            timingTable->setItem(row, 4, new QTableWidgetItem(ms(histogram["p50"])));
+            timingTable->setItem(row, 5, new QTableWidgetItem(ms(histogram["p90"])));
+            timingTable->setItem(row, 6, new QTableWidgetItem(ms(histogram["p99"])));
+            timingTable->setItem(row, 7, new QTableWidgetItem(ms(histogram["max"])));
+            row++;
+        }
+    }
+    metricsLabel->setText(QString("%1 requests, %2 transport errors. Connect/TLS rows only count new connections.")
+                              .arg(requests).arg(errors));
+}
+
+void DiagnosticsPanel::saveMetricsJson()
+{
+    if (lastMetricsJson.isEmpty()) {
+        metricsLabel->setText("Nothing recorded yet.");
+        return;
+    }
+
+    QFile file(METRICS_DUMP_FILE);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        metricsLabel->setText(QString("Could not write %1: %2").arg(METRICS_DUMP_FILE, file.errorString()));
+        return;
+    }
+    file.write(lastMetricsJson.toUtf8());
+    metricsLabel->setText(QString("Saved to %1").arg(QFileInfo(file).absoluteFilePath()));
+}
+
+void DiagnosticsPanel::setEndpointStatus(const QVector<EndpointStatus>& endpoints, const QString& selected, const QString& reason)
+{
+    selectionLabel->setText(selected.isEmpty() ? QString("No endpoint selected.")
+                                               : QString("Requests go to %1: %2").arg(selected, reason));
+
+    endpointTable->setRowCount(endpoints.size());
+    for (int row = 0; row < endpoints.size(); ++row) {
+        const EndpointStatus& endpoint = endpoints[row];
+        QString state = endpoint.healthy ? (endpoint.probed ? "healthy" : "unprobed") : QString("down (%1x)").arg(endpoint.consecutiveFailures);
+        if (endpoint.host == selected) state += ", selected";
+
+        endpointTable->setItem(row, 0, new QTableWidgetItem(endpoint.host));
+        endpointTable->setItem(row, 1, new QTableWidgetItem(state));
+        endpointTable->setItem(row, 2, new QTableWidgetItem(endpoint.probed ? QString::number(endpoint.rttMs, 'f', 1) : QString("-")));
+        endpointTable->setItem(row, 3, new QTableWidgetItem(QString::number(endpoint.requests)));
+        endpointTable->setItem(row, 4, new QTableWidgetItem(QString::number(endpoint.failures)));
+        endpointTable->setItem(row, 5, new QTableWidgetItem(endpoint.lastError));
+    }
+    endpointTable->resizeColumnsToContents();
+}
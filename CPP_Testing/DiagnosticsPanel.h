@@ -0,0 +1,43 @@
+#ifndef DIAGNOSTICSPANEL_H
+#define DIAGNOSTICSPANEL_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QTableWidget>
+#include <QVector>
+#include "EndpointSelector.h"
+
+// --- DiagnosticsPanel ---
+// Read-only view of the network state: which cluster endpoint requests are routed
+// to and why, the health and RTT of every configured endpoint, and request timing
+// percentiles per endpoint and phase (refreshed once a second while visible).
+class DiagnosticsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsPanel(QWidget *parent = nullptr);
+
+public slots:
+    void setEndpointStatus(const QVector<EndpointStatus>& endpoints, const QString& selected, const QString& reason);
+    void setRequestMetrics(const QString& json);
+
+signals:
+    // Asks the API manager for a fresh RequestMetrics snapshot
+    void metricsRequested();
+
+private:
+    void saveMetricsJson();
+
+    QLabel *selectionLabel = nullptr;
+    QTableWidget *endpointTable = nullptr;
+    QTableWidget *timingTable = nullptr;
+    QLabel *metricsLabel = nullptr;
+    QPushButton *saveJsonButton = nullptr;
+    QTimer refreshTimer;
+    QString lastMetricsJson;
+};
+
+#endif // DIAGNOSTICSPANEL_H
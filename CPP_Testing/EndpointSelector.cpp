@@ -0,0 +1,234 @@
+#include "EndpointSelector.h"
+#include <QDebug>
+#include <QRegularExpression>
+#include <curl/curl.h>
+#include "Tracing.h"
+
+// --- CONSTANTS ---
+const int PROBE_INTERVAL_MS = 5000;
+const long PROBE_TIMEOUT_MS = 2000;
+const double RTT_SMOOTHING = 0.3;    // Weight of the newest probe in the RTT average
+const double SWITCH_MARGIN = 0.2;    // Only move off a healthy endpoint for a >20% faster one
+
+EndpointSelector::EndpointSelector(ApiRequestEngine *engine, int port, bool verifySsl, QObject *parent)
+    : QObject(parent), engine(engine), port(port), verifySsl(verifySsl)
+{
+    probeTimer.setInterval(PROBE_INTERVAL_MS);
+    connect(&probeTimer, &QTimer::timeout, this, &EndpointSelector::probeAll);
+}
+
+QStringList EndpointSelector::parseHostList(const QString& text)
+{
+    QStringList hosts;
+    for (const QString& part : text.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts)) {
+        if (!hosts.contains(part)) hosts.append(part);
+    }
+    return hosts;
+}
+
+void EndpointSelector::setEndpoints(const QStringList& hosts)
+{
+    generation++;
+    table.clear();
+    for (const QString& host : hosts) {
+        EndpointStatus endpoint;
+        endpoint.host = host;
+        table.append(endpoint);
+    }
+    currentIndex = table.isEmpty() ? -1 : 0;
+    reason = table.isEmpty() ? QString("no endpoints configured") : QString("first configured endpoint (not probed yet)");
+
+    // A single endpoint has nothing to choose from; don't spend requests probing it
+    if (table.size() > 1) {
+        probeAll();
+        probeTimer.start();
+    } else {
+        probeTimer.stop();
+    }
+    emit statusChanged(table, current(), reason);
+}
+
+QStringList EndpointSelector::endpoints() const
+{
+    QStringList hosts;
+    for (const EndpointStatus& endpoint : table) hosts.append(endpoint.host);
+    return hosts;
+}
+
+QString EndpointSelector::current() const
+{
+    return (currentIndex >= 0 && currentIndex < table.size()) ? table[currentIndex].host : QString();
+}
+
+int EndpointSelector::indexOf(const QString& host) const
+{
+    for (int i = 0; i < table.size(); ++i) {
+        if (table[i].host == host) return i;
+    }
+    return -1;
+}
+
+bool EndpointSelector::isHealthy(const QString& host) const
+{
+    int index = indexOf(host);
+    return index >= 0 && table[index].healthy;
+}
+
+// --- SELECTION ---
+
+/**
+ * @brief Ranks the endpoints not in 'exclude': healthy before unhealthy; among
+ * healthy ones, probed by RTT, then unprobed in configured order; among unhealthy
+ * ones, the fewest consecutive failures.
+ */
+int EndpointSelector::bestIndex(const QStringList& exclude) const
+{
+    int best = -1;
+    auto better = [this](int a, int b) {
+        const EndpointStatus& x = table[a];
+        const EndpointStatus& y = table[b];
+        if (x.healthy != y.healthy) return x.healthy;
+        if (!x.healthy) return x.consecutiveFailures < y.consecutiveFailures;
+        if (x.probed != y.probed) return x.probed;
+        return x.probed && x.rttMs < y.rttMs;
+    };
+
+    for (int i = 0; i < table.size(); ++i) {
+        if (exclude.contains(table[i].host)) continue;
+        if (best < 0 || better(i, best)) best = i;
+    }
+    return best;
+}
+
+QString EndpointSelector::select(const QStringList& exclude) const
+{
+    if (currentIndex >= 0 && currentIndex < table.size()) {
+        const EndpointStatus& endpoint = table[currentIndex];
+        if (endpoint.healthy && !exclude.contains(endpoint.host)) return endpoint.host;
+    }
+    int best = bestIndex(exclude);
+    return best >= 0 ? table[best].host : QString();
+}
+
+/**
+ * @brief Re-evaluates the current endpoint after new health/RTT data. A healthy
+ * current endpoint is only abandoned for one that is clearly faster, so small RTT
+ * jitter does not make requests hop between nodes.
+ */
+void EndpointSelector::reselect()
+{
+    int best = bestIndex(QStringList());
+    if (best < 0) return;
+
+    int previous = currentIndex;
+    const EndpointStatus& candidate = table[best];
+    if (previous >= 0 && previous != best && table[previous].healthy) {
+        const EndpointStatus& active = table[previous];
+        bool clearlyFaster = candidate.probed && active.probed && candidate.rttMs < active.rttMs * (1.0 - SWITCH_MARGIN);
+        if (!clearlyFaster) {
+            reason = active.probed
+                ? QString("kept %1 (%2 ms): %3 is not >%4% faster").arg(active.host).arg(active.rttMs, 0, 'f', 1)
+                      .arg(candidate.host).arg(qRound(SWITCH_MARGIN * 100))
+                : QString("kept %1: not probed yet").arg(active.host);
+            emit statusChanged(table, current(), reason);
+            return;
+        }
+    }
+
+    currentIndex = best;
+    if (!candidate.healthy) {
+        reason = QString("no healthy endpoint; using %1 (fewest failures)").arg(candidate.host);
+    } else if (candidate.probed) {
+        reason = QString("fastest healthy endpoint (%1 ms)").arg(candidate.rttMs, 0, 'f', 1);
+    } else {
+        reason = QString("first healthy endpoint (not probed yet)");
+    }
+    if (previous != currentIndex && previous >= 0) {
+        qInfo() << "API endpoint switched from" << table[previous].host << "to" << candidate.host << "-" << reason;
+        PVE_TRACE_EVENT("EndpointSelector::switch", previous, currentIndex);
+    }
+    emit statusChanged(table, current(), reason);
+}
+
+// --- HEALTH ---
+
+bool EndpointSelector::isTransportFailure(const ApiResponse& response)
+{
+    // 502-504 come from proxies, 595/596 from pveproxy when it cannot reach the target.
+    // Other statuses (401, 500 "VM already running", ...) are API answers, not node failures.
+    if (response.curlCode != CURLE_OK || response.httpCode == 0) return true;
+    switch (response.httpCode) {
+        case 502: case 503: case 504: case 595: case 596:
+            return true;
+    }
+    return false;
+}
+
+void EndpointSelector::markResult(int index, bool reached, const QString& error)
+{
+    EndpointStatus& endpoint = table[index];
+    endpoint.healthy = reached;
+    if (reached) {
+        endpoint.consecutiveFailures = 0;
+    } else {
+        endpoint.consecutiveFailures++;
+        endpoint.lastError = error;
+    }
+}
+
+void EndpointSelector::reportResult(const QString& host, const ApiResponse& response)
+{
+    int index = indexOf(host);
+    if (index < 0) return;
+
+    EndpointStatus& endpoint = table[index];
+    bool wasHealthy = endpoint.healthy;
+    bool failed = isTransportFailure(response);
+    endpoint.requests++;
+    if (failed) endpoint.failures++;
+
+    QString error = (response.curlCode != CURLE_OK) ? QString(curl_easy_strerror(response.curlCode))
+                                                    : QString("HTTP %1").arg(response.httpCode);
+    markResult(index, !failed, error);
+    if (endpoint.healthy != wasHealthy) reselect();
+}
+
+// --- PROBING ---
+
+void EndpointSelector::probeAll()
+{
+    for (int i = 0; i < table.size(); ++i) {
+        probe(i);
+    }
+}
+
+void EndpointSelector::probe(int index)
+{
+    QString host = table[index].host;
+
+    ApiRequest request;
+    request.url = "https://" + host.toStdString() + ":" + std::to_string(port) + "/api2/json/version";
+    request.verifySsl = verifySsl;
+    request.timeoutMs = PROBE_TIMEOUT_MS;
+    request.metricsLabel = "probe";
+
+    quint64 probeGeneration = generation;
+    engine->submit(request, this, [this, host, probeGeneration](const ApiResponse& response) {
+        if (probeGeneration != generation) return;
+        int i = indexOf(host);
+        if (i < 0) return;
+
+        // Unauthenticated, so 401 is the expected answer: pveproxy is up
+        bool reached = !isTransportFailure(response);
+        EndpointStatus& endpoint = table[i];
+        if (reached) {
+            double sample = response.timing.totalUs / 1000.0;
+            endpoint.rttMs = endpoint.probed ? (1.0 - RTT_SMOOTHING) * endpoint.rttMs + RTT_SMOOTHING * sample : sample;
+            endpoint.probed = true;
+        }
+        QString error = (response.curlCode != CURLE_OK) ? QString(curl_easy_strerror(response.curlCode))
+                                                        : QString("HTTP %1").arg(response.httpCode);
+        markResult(i, reached, error);
+        reselect();
+    });
+}
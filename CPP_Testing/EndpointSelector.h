@@ -0,0 +1,87 @@
+#ifndef ENDPOINTSELECTOR_H
+#define ENDPOINTSELECTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include "ApiRequestEngine.h"
+
+// --- DATA STRUCTURES ---
+struct EndpointStatus
+{
+    QString host;
+    bool healthy = true;         // pveproxy answered the last probe / request
+    bool probed = false;         // At least one probe has completed
+    double rttMs = -1.0;         // Smoothed probe round trip (EWMA); -1 until probed
+    int consecutiveFailures = 0;
+    quint64 requests = 0;        // API requests routed to this endpoint
+    quint64 failures = 0;        // ...of which failed at the transport level
+    QString lastError;
+};
+
+Q_DECLARE_METATYPE(EndpointStatus)
+
+// --- EndpointSelector ---
+// Chooses which cluster node's pveproxy receives API requests. Every node can
+// answer cluster-wide calls, so the selector probes each configured endpoint in the
+// background (unauthenticated GET /version: any HTTP answer proves pveproxy is up)
+// and routes to the fastest healthy one. Results of real requests feed back in, so
+// a node that starts failing is dropped before the next probe round.
+// Lives on (and must only be used from) the API manager's thread.
+class EndpointSelector : public QObject
+{
+    Q_OBJECT
+
+public:
+    EndpointSelector(ApiRequestEngine *engine, int port, bool verifySsl, QObject *parent = nullptr);
+
+    // Splits "node1, node2 node3" into hosts
+    static QStringList parseHostList(const QString& text);
+
+    // Replaces the endpoint list and starts probing it
+    void setEndpoints(const QStringList& hosts);
+    QStringList endpoints() const;
+    int count() const { return table.size(); }
+
+    // Endpoint for the next request: the current choice, or the best one not in 'exclude'.
+    // Returns an empty string if every endpoint is excluded.
+    QString select(const QStringList& exclude = QStringList()) const;
+    bool isHealthy(const QString& host) const;
+
+    // Feeds the outcome of a real request back into the health state
+    void reportResult(const QString& host, const ApiResponse& response);
+
+    // True if the response says nothing about the API itself (node or proxy unreachable)
+    static bool isTransportFailure(const ApiResponse& response);
+
+    QVector<EndpointStatus> status() const { return table; }
+    QString current() const;
+    QString selectionReason() const { return reason; }
+
+signals:
+    void statusChanged(const QVector<EndpointStatus>& endpoints, const QString& selected, const QString& reason);
+
+private slots:
+    void probeAll();
+
+private:
+    void probe(int index);
+    void markResult(int index, bool reached, const QString& error);
+    void reselect();
+    int indexOf(const QString& host) const;
+    int bestIndex(const QStringList& exclude) const;
+
+    ApiRequestEngine *engine;
+    int port;
+    bool verifySsl;
+
+    QTimer probeTimer;
+    QVector<EndpointStatus> table;
+    int currentIndex = -1;
+    QString reason;
+    quint64 generation = 0;   // Bumped by setEndpoints; probe results of an older list are ignored
+};
+
+#endif // ENDPOINTSELECTOR_H
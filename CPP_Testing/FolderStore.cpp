@@ -0,0 +1,477 @@
+#include "FolderStore.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cstring>
+#include <fstream>
+#include "json.hpp"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+// --- CONSTANTS ---
+const int BATCH_WINDOW_MS = 200;            // Assignments arriving within this window share one fsync
+const quint64 COMPACT_MIN_RECORDS = 1000;   // Journal length before compaction is considered
+const char SNAPSHOT_MAGIC[4] = {'P', 'V', 'E', 'F'};
+const quint32 SNAPSHOT_VERSION = 1;
+const qint64 SNAPSHOT_HEADER_BYTES = 16;
+const qint64 SNAPSHOT_ENTRY_BYTES = 8;
+
+static bool syncToDisk(QFileDevice& file)
+{
+    if (!file.flush()) return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+// Bounds-checked cursor over the mapped snapshot
+namespace {
+struct SnapshotReader
+{
+    const uchar *pos;
+    const uchar *end;
+
+    bool readU32(quint32& value)
+    {
+        if (end - pos < 4) return false;
+        value = qFromLittleEndian<quint32>(pos);
+        pos += 4;
+        return true;
+    }
+
+    bool skip(qint64 bytes, const uchar *&start)
+    {
+        if (bytes < 0 || end - pos < bytes) return false;
+        start = pos;
+        pos += bytes;
+        return true;
+    }
+};
+
+void appendU32(std::string& out, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    out.append(reinterpret_cast<const char*>(bytes), 4);
+}
+} // namespace
+
+FolderStore::FolderStore(const QString& snapshotPath, const QString& journalPath, const QString& legacyJsonPath)
+    : snapshotPath(snapshotPath), journalPath(journalPath), legacyJsonPath(legacyJsonPath)
+{
+}
+
+FolderStore::~FolderStore()
+{
+    close();
+}
+
+// --- LOADING ---
+
+/**
+ * @brief Reads the binary snapshot (or migrates the legacy JSON file), replays the
+ * journal on top of it and starts the background writer.
+ */
+std::map<int, std::string> FolderStore::load()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    std::map<int, std::string> folders;
+    SnapshotState snapshot = readSnapshot(folders);
+    if (snapshot == SnapshotState::Unreadable) {
+        setAsideUnreadableSnapshot();
+    }
+
+    if (snapshot == SnapshotState::Loaded) {
+        qInfo() << "Loaded" << folders.size() << "VM folder assignments from" << snapshotPath
+                << "in" << timer.nsecsElapsed() / 1000 << "us";
+    } else if (readLegacyJson(folders)) {
+        qInfo() << "Loaded" << folders.size() << "VM folder assignments from" << legacyJsonPath
+                << "in" << timer.nsecsElapsed() / 1000 << "us; migrating to" << snapshotPath;
+        migrationPending = true;
+    } else if (snapshot == SnapshotState::Missing) {
+        qInfo() << "Folder configuration file (" << snapshotPath << ") not found. Starting fresh.";
+    }
+
+    bool damaged = false;
+    int replayed = replayJournal(folders, damaged);
+    if (replayed > 0) {
+        qInfo() << "Replayed" << replayed << "journaled folder assignments from" << journalPath;
+    }
+
+    current = folders;
+    recordsSinceCompaction = replayed;
+
+    journal.setFileName(journalPath);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCritical() << "Error: Could not open" << journalPath << "for writing:" << journal.errorString();
+    }
+
+    // Appending after a torn record would glue the next record onto it (and lose it on
+    // the next replay); fold everything readable into the snapshot and start empty.
+    // If that fails, at least start the next record on a line of its own.
+    if (damaged && !compact() && journal.isOpen()) {
+        journal.write("\n", 1);
+    }
+
+    if (!writerThread) {
+        writerThread = QThread::create([this]() { writerLoop(); });
+        writerThread->setObjectName("FolderStoreWriter");
+        writerThread->start();
+    }
+    return folders;
+}
+
+/**
+ * @brief Reads the binary snapshot. Unless it returns Loaded, 'folders' is left empty;
+ * Unreadable means the file exists (so it may hold assignments) but could not be used.
+ */
+FolderStore::SnapshotState FolderStore::readSnapshot(std::map<int, std::string>& folders) const
+{
+    QFile file(snapshotPath);
+    if (!file.exists()) return SnapshotState::Missing;
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Warning: Could not open" << snapshotPath << ":" << file.errorString();
+        return SnapshotState::Unreadable;
+    }
+
+    qint64 size = file.size();
+    if (size < SNAPSHOT_HEADER_BYTES) {
+        qWarning() << "Warning:" << snapshotPath << "is truncated.";
+        return SnapshotState::Unreadable;
+    }
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        qWarning() << "Warning: Could not map" << snapshotPath << ":" << file.errorString();
+        return SnapshotState::Unreadable;
+    }
+
+    SnapshotReader reader{data, data + size};
+    const uchar *magic = nullptr;
+    quint32 version = 0, folderCount = 0, entryCount = 0;
+    bool ok = reader.skip(4, magic) && std::memcmp(magic, SNAPSHOT_MAGIC, 4) == 0
+              && reader.readU32(version) && version == SNAPSHOT_VERSION
+              && reader.readU32(folderCount) && reader.readU32(entryCount);
+
+    // Folder name table
+    std::vector<std::string> names;
+    if (ok) names.reserve(qMin<quint32>(folderCount, static_cast<quint32>(size)));
+    for (quint32 n = 0; ok && n < folderCount; ++n) {
+        quint32 length = 0;
+        const uchar *bytes = nullptr;
+        ok = reader.readU32(length) && reader.skip(length, bytes);
+        if (ok) names.emplace_back(reinterpret_cast<const char*>(bytes), length);
+    }
+
+    // Fixed-stride entries, already sorted, so each insert is at the end of the map
+    const uchar *entries = nullptr;
+    ok = ok && reader.skip(static_cast<qint64>(entryCount) * SNAPSHOT_ENTRY_BYTES, entries);
+    for (quint32 n = 0; ok && n < entryCount; ++n) {
+        const uchar *entry = entries + n * SNAPSHOT_ENTRY_BYTES;
+        qint32 vmid = qFromLittleEndian<qint32>(entry);
+        quint32 folderIndex = qFromLittleEndian<quint32>(entry + 4);
+        ok = folderIndex < names.size();
+        if (ok) folders.emplace_hint(folders.end(), vmid, names[folderIndex]);
+    }
+
+    file.unmap(const_cast<uchar*>(data));
+    if (!ok) {
+        // Also a snapshot from a newer version of the client
+        qWarning() << "Warning: Could not parse" << snapshotPath << "(format version" << version << ")";
+        folders.clear();
+        return SnapshotState::Unreadable;
+    }
+    return SnapshotState::Loaded;
+}
+
+/**
+ * @brief Moves an unreadable snapshot out of compaction's way, keeping it for manual
+ * recovery. If it cannot be moved, compaction is switched off for this session so the
+ * file is never replaced by a snapshot holding only the journal's changes.
+ */
+void FolderStore::setAsideUnreadableSnapshot()
+{
+    const QString aside = snapshotPath + ".corrupt-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    if (QFile::rename(snapshotPath, aside)) {
+        warning = QString("The folder configuration %1 could not be read and was moved to %2. "
+                          "Folder assignments made before this were not loaded.").arg(snapshotPath, aside);
+    } else {
+        snapshotBlocked = true;
+        warning = QString("The folder configuration %1 could not be read, nor moved aside. Folder changes "
+                          "are kept in %2 only until the file is removed or repaired.").arg(snapshotPath, journalPath);
+    }
+    qCritical().noquote() << "Error:" << warning;
+}
+
+/**
+ * @brief Reads the pre-binary JSON file ({"<vmid>": "<folder>", ...}).
+ */
+bool FolderStore::readLegacyJson(std::map<int, std::string>& folders) const
+{
+    std::ifstream i(legacyJsonPath.toStdString());
+    if (i.is_open()) {
+        try {
+            json j;
+            i >> j;
+            if (j.is_object()) {
+                for (auto it = j.begin(); it != j.end(); ++it) {
+                    try {
+                        int vmid = std::stoi(it.key());
+                        folders[vmid] = it.value().get<std::string>();
+                    } catch (const std::exception& e) {
+                        qWarning() << "Warning: Skipping invalid entry in folder file:" << QString::fromStdString(it.key());
+                    }
+                }
+            }
+            return true;
+        } catch (const json::parse_error& e) {
+            qWarning() << "Warning: Could not parse" << legacyJsonPath << ". Starting with no folder assignments.";
+        }
+    }
+    return false;
+}
+
+int FolderStore::replayJournal(std::map<int, std::string>& folders, bool& damaged) const
+{
+    std::ifstream i(journalPath.toStdString());
+    if (!i.is_open()) return 0;
+
+    int replayed = 0;
+    std::string line;
+    while (std::getline(i, line)) {
+        if (line.empty()) continue;
+
+        // A torn record (crash mid-append) can only be the last line; skip it
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.contains("vmid") || !record.contains("folder")) {
+            qWarning() << "Warning: Skipping damaged record in" << journalPath;
+            damaged = true;
+            continue;
+        }
+        try {
+            folders[record["vmid"].get<int>()] = record["folder"].get<std::string>();
+            replayed++;
+        } catch (const json::exception& e) {
+            qWarning() << "Warning: Skipping invalid record in" << journalPath << ":" << e.what();
+            damaged = true;
+        }
+    }
+    return replayed;
+}
+
+// --- WRITING (any thread) ---
+
+void FolderStore::assign(int vmid, const std::string& folder)
+{
+    QMutexLocker locker(&mutex);
+    pending.push_back(Record{vmid, folder});
+    workAvailable.wakeOne();
+}
+
+void FolderStore::close()
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (!writerThread) return;
+        stopRequested = true;
+        workAvailable.wakeOne();
+    }
+
+    // The writer drains everything still pending and compacts before it exits
+    writerThread->wait();
+    delete writerThread;
+    writerThread = nullptr;
+    journal.close();
+}
+
+// --- BACKGROUND WRITER ---
+
+void FolderStore::writerLoop()
+{
+    if (migrationPending && compact()) {
+        // The binary snapshot now holds everything; keep the old file only as a backup
+        QFile::remove(legacyJsonPath + ".migrated");
+        if (QFile::rename(legacyJsonPath, legacyJsonPath + ".migrated")) {
+            qInfo() << "Migrated" << legacyJsonPath << "to" << snapshotPath;
+        }
+        migrationPending = false;
+    }
+
+    for (;;) {
+        std::vector<Record> batch;
+        bool stopping;
+        {
+            QMutexLocker locker(&mutex);
+            while (pending.empty() && !stopRequested) {
+                workAvailable.wait(&mutex);
+            }
+
+            // Give a burst of assignments (e.g. moving a whole selection) time to
+            // arrive so they are written and synced together. Each assign() wakes us,
+            // so wait against a deadline set by the batch's first change; only a stop
+            // ends the window early.
+            QDeadlineTimer deadline(BATCH_WINDOW_MS);
+            while (!stopRequested && !deadline.hasExpired()) {
+                workAvailable.wait(&mutex, deadline);
+            }
+
+            batch.swap(pending);
+            stopping = stopRequested;
+        }
+
+        if (!batch.empty()) {
+            appendToJournal(batch);   // Logs its own errors; the mapping stays current in memory
+            for (const Record& record : batch) {
+                current[record.vmid] = record.folder;
+            }
+            recordsSinceCompaction += batch.size();
+        }
+
+        // Keep the journal no longer than the snapshot, so replay stays cheap and
+        // compaction cost is amortized over at least as many assignments
+        bool journalLong = recordsSinceCompaction >= COMPACT_MIN_RECORDS && recordsSinceCompaction >= current.size();
+        if (journalLong || (stopping && recordsSinceCompaction > 0)) {
+            compact();
+        }
+
+        if (stopping) {
+            QMutexLocker locker(&mutex);
+            if (pending.empty()) return;
+        }
+    }
+}
+
+bool FolderStore::appendToJournal(const std::vector<Record>& batch)
+{
+    if (!journal.isOpen()) return false;
+
+    std::string lines;
+    for (const Record& record : batch) {
+        lines += json{{"vmid", record.vmid}, {"folder", record.folder}}.dump();
+        lines += '\n';
+    }
+
+    if (journal.write(lines.data(), static_cast<qint64>(lines.size())) != static_cast<qint64>(lines.size())) {
+        qCritical() << "Error: Could not append to" << journalPath << ":" << journal.errorString();
+        return false;
+    }
+    if (!syncToDisk(journal)) {
+        qCritical() << "Error: Could not sync" << journalPath;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Rewrites the binary snapshot from the in-memory mapping and empties the journal.
+ * QSaveFile writes to a temporary file, syncs it and renames it over the snapshot,
+ * so a crash leaves either the old or the new snapshot, never a partial one. If we
+ * crash after the rename but before the journal is truncated, replaying the journal
+ * over the new snapshot yields the same mapping.
+ */
+bool FolderStore::compact()
+{
+    if (snapshotBlocked) return false;   // Logged once by setAsideUnreadableSnapshot
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Folder names are shared by many VMs; store each one once
+    std::map<std::string, quint32> folderIndex;
+    std::vector<const std::string*> names;
+    for (const auto& pair : current) {
+        auto inserted = folderIndex.emplace(pair.second, static_cast<quint32>(names.size()));
+        if (inserted.second) names.push_back(&inserted.first->first);
+    }
+
+    std::string text;
+    text.reserve(SNAPSHOT_HEADER_BYTES + current.size() * (SNAPSHOT_ENTRY_BYTES + 4));
+    text.append(SNAPSHOT_MAGIC, 4);
+    appendU32(text, SNAPSHOT_VERSION);
+    appendU32(text, static_cast<quint32>(names.size()));
+    appendU32(text, static_cast<quint32>(current.size()));
+    for (const std::string *name : names) {
+        appendU32(text, static_cast<quint32>(name->size()));
+        text.append(*name);
+    }
+    for (const auto& pair : current) {
+        appendU32(text, static_cast<quint32>(pair.first));
+        appendU32(text, folderIndex[pair.second]);
+    }
+
+    QSaveFile file(snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(text.data(), static_cast<qint64>(text.size())) != static_cast<qint64>(text.size())
+        || !file.commit()) {
+        qCritical() << "Error: Could not write" << snapshotPath << ":" << file.errorString();
+        return false;
+    }
+
+    if (journal.isOpen() && (!journal.resize(0) || !syncToDisk(journal))) {
+        qWarning() << "Warning: Could not truncate" << journalPath << "after compaction";
+    }
+
+    qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    qInfo() << "Compacted" << recordsSinceCompaction << "journaled changes into" << current.size()
+            << "VM folder assignments in" << snapshotPath << "(" << elapsedUs << "us)";
+    recordsSinceCompaction = 0;
+    return true;
+}
+
+// --- BENCHMARK ---
+
+QString FolderStore::benchmark(int assignments)
+{
+    const int FOLDERS = 100;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) return QString("Folder store benchmark: could not create a temporary directory");
+    const QString snapshotFile = dir.filePath("vm_folders.bin");
+    const QString journalFile = dir.filePath("vm_folders.journal");
+    const QString legacyFile = dir.filePath("vm_folders.json");
+
+    json legacy = json::object();
+    for (int i = 0; i < assignments; ++i) {
+        legacy[std::to_string(100 + i)] = "Folder " + std::to_string(i % FOLDERS);
+    }
+    {
+        std::ofstream out(legacyFile.toStdString());
+        out << legacy.dump();
+    }
+
+    QElapsedTimer timer;
+    size_t jsonLoaded = 0, binaryLoaded = 0;
+    qint64 jsonUs = 0, binaryUs = 0;
+    {
+        FolderStore store(snapshotFile, journalFile, legacyFile);
+        timer.start();
+        jsonLoaded = store.load().size();
+        jsonUs = timer.nsecsElapsed() / 1000;
+    }   // close() waits for the migration to the snapshot
+    {
+        FolderStore store(snapshotFile, journalFile, legacyFile);
+        timer.restart();
+        binaryLoaded = store.load().size();
+        binaryUs = timer.nsecsElapsed() / 1000;
+    }
+
+    return QString("Folder store benchmark, %1 assignments in %2 folders: JSON %3 ms (%4 KiB) vs snapshot %5 ms (%6 KiB), "
+                   "%7/%8 loaded")
+        .arg(assignments).arg(FOLDERS).arg(jsonUs / 1000.0, 0, 'f', 1).arg(QFileInfo(legacyFile + ".migrated").size() / 1024)
+        .arg(binaryUs / 1000.0, 0, 'f', 1).arg(QFileInfo(snapshotFile).size() / 1024)
+        .arg(static_cast<qulonglong>(jsonLoaded)).arg(static_cast<qulonglong>(binaryLoaded));
+}
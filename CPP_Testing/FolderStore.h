@@ -0,0 +1,93 @@
+#ifndef FOLDERSTORE_H
+#define FOLDERSTORE_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <map>
+#include <string>
+#include <vector>
+
+// --- FolderStore ---
+// Write-behind persistence for the VMID -> folder mapping. assign() only queues the
+// change in memory; a background writer appends queued changes to a journal file
+// (one JSON record per line, one fsync per batch) and periodically compacts the
+// journal into a binary snapshot file via an atomic temp-file rename.
+// A crash loses at most the last unflushed batch; a torn last journal line is skipped
+// on load and the journal is compacted at once, so new records never follow it.
+//
+// Snapshot layout (little-endian, memory-mapped on load):
+//   header   "PVEF", version, folderCount, entryCount   (4 x 4 bytes)
+//   folders  folderCount x { byteLength, UTF-8 bytes }   (each name stored once)
+//   entries  entryCount x { vmid, folderIndex }          (8 bytes each, sorted by vmid)
+// An older vm_folders.json is read once and migrated to this format. A snapshot that
+// exists but cannot be read is renamed to "<snapshot>.corrupt-<time>" rather than
+// compacted over; if that fails, compaction stays off and the journal keeps growing.
+class FolderStore
+{
+public:
+    FolderStore(const QString& snapshotPath, const QString& journalPath, const QString& legacyJsonPath);
+    ~FolderStore();
+    FolderStore(const FolderStore&) = delete;
+    FolderStore& operator=(const FolderStore&) = delete;
+
+    // Reads the snapshot, replays the journal on top of it and starts the writer.
+    std::map<int, std::string> load();
+
+    // Queues an assignment; never touches the disk. Thread-safe.
+    void assign(int vmid, const std::string& folder);
+
+    // Flushes, compacts the journal into the snapshot and stops the writer.
+    void close();
+
+    // Set by load() when the snapshot could not be read and had to be set aside (for
+    // the user; empty if loading went fine)
+    QString loadWarning() const { return warning; }
+
+    // Writes 'assignments' synthetic entries as a legacy JSON file in a temporary
+    // directory and times load() from it against load() from the migrated binary
+    // snapshot. Returns a summary line.
+    static QString benchmark(int assignments);
+
+private:
+    struct Record
+    {
+        int vmid;
+        std::string folder;
+    };
+
+    void writerLoop();
+    bool appendToJournal(const std::vector<Record>& batch);
+    bool compact();
+
+    enum class SnapshotState { Loaded, Missing, Unreadable };
+    SnapshotState readSnapshot(std::map<int, std::string>& folders) const;
+    void setAsideUnreadableSnapshot();
+    bool readLegacyJson(std::map<int, std::string>& folders) const;
+    // Returns the number of records applied; 'damaged' is set if any line was unreadable
+    int replayJournal(std::map<int, std::string>& folders, bool& damaged) const;
+
+    QString snapshotPath;
+    QString journalPath;
+    QString legacyJsonPath;
+    bool migrationPending = false;        // Snapshot still has to be written from legacy JSON
+    bool snapshotBlocked = false;         // Unreadable snapshot still in place: never compact over it
+    QString warning;
+
+    // Writer thread state (only touched by the writer once it runs)
+    QFile journal;
+    std::map<int, std::string> current;   // Mapping as persisted (snapshot + journal)
+    quint64 recordsSinceCompaction = 0;
+
+    // Shared with callers, guarded by mutex
+    QMutex mutex;
+    QWaitCondition workAvailable;
+    std::vector<Record> pending;
+    bool stopRequested = false;
+
+    QThread *writerThread = nullptr;
+};
+
+#endif // FOLDERSTORE_H
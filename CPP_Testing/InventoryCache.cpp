@@ -0,0 +1,89 @@
+#include "InventoryCache.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+// --- CONSTANTS ---
+const quint32 CACHE_MAGIC = 0x50564549; // "PVEI"
+const quint32 CACHE_VERSION = 2;        // 2: usage metrics, pool, tags, HA state, template flag
+const qint32 CACHE_MAX_VMS = 1000000;   // Sanity bound against a corrupt count
+
+/**
+ * @brief Writes the inventory atomically (temp file + rename), so a crash never
+ * leaves a half-written cache behind.
+ */
+bool InventoryCache::save(const QString& path, const QString& host, const QVector<Vm>& vms)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Warning: Could not open" << path << "for writing:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << CACHE_MAGIC << CACHE_VERSION;
+    out << host << static_cast<qint64>(QDateTime::currentMSecsSinceEpoch());
+    out << static_cast<qint32>(vms.size());
+    for (const Vm& vm : vms) {
+        out << static_cast<qint32>(vm.vmid) << vm.type << vm.status << vm.node << vm.name << vm.folder;
+        out << vm.pool << vm.tags << vm.hastate << vm.isTemplate << vm.cpu << static_cast<qint32>(vm.maxcpu)
+            << vm.mem << vm.maxmem << vm.disk << vm.maxdisk << vm.netin << vm.netout << vm.diskread << vm.diskwrite
+            << vm.uptime;
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Warning: Could not write" << path << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool InventoryCache::load(const QString& path, Snapshot& snapshot)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0;
+    qint64 savedAtMs = 0;
+    qint32 count = 0;
+    in >> magic >> version;
+    if (magic != CACHE_MAGIC || version < 1 || version > CACHE_VERSION) {
+        qWarning() << "Warning: Ignoring" << path << "(unknown format or version)";
+        return false;
+    }
+    in >> snapshot.host >> savedAtMs >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || count > CACHE_MAX_VMS) {
+        qWarning() << "Warning: Ignoring damaged inventory cache" << path;
+        return false;
+    }
+
+    snapshot.savedAt = QDateTime::fromMSecsSinceEpoch(savedAtMs);
+    snapshot.vms.clear();
+    snapshot.vms.reserve(count);
+    for (qint32 n = 0; n < count; ++n) {
+        Vm vm;
+        qint32 vmid = 0;
+        in >> vmid >> vm.type >> vm.status >> vm.node >> vm.name >> vm.folder;
+        vm.vmid = vmid;
+        if (version >= 2) {
+            qint32 maxcpu = 0;
+            in >> vm.pool >> vm.tags >> vm.hastate >> vm.isTemplate >> vm.cpu >> maxcpu
+               >> vm.mem >> vm.maxmem >> vm.disk >> vm.maxdisk >> vm.netin >> vm.netout >> vm.diskread >> vm.diskwrite
+               >> vm.uptime;
+            vm.maxcpu = maxcpu;
+        }
+        snapshot.vms.append(vm);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Warning: Ignoring truncated inventory cache" << path;
+        snapshot.vms.clear();
+        return false;
+    }
+    return true;
+}
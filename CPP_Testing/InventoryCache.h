@@ -0,0 +1,28 @@
+#ifndef INVENTORYCACHE_H
+#define INVENTORYCACHE_H
+
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+#include "ProxmoxApiManager.h" // For Vm struct
+
+// --- InventoryCache ---
+// Last-known cluster inventory, written after every successful refresh and read at
+// startup so the tree can be shown (marked stale) before login and the first live
+// fetch complete. The file is a versioned QDataStream; anything unreadable is ignored.
+// Version 1 files (identity fields only) still load, with empty usage columns.
+class InventoryCache
+{
+public:
+    struct Snapshot
+    {
+        QString host;          // Host the inventory was fetched from
+        QDateTime savedAt;
+        QVector<Vm> vms;
+    };
+
+    static bool save(const QString& path, const QString& host, const QVector<Vm>& vms);
+    static bool load(const QString& path, Snapshot& snapshot);
+};
+
+#endif // INVENTORYCACHE_H
@@ -0,0 +1,221 @@
+#include "MetricChart.h"
+#include <QDateTime>
+#include <QPainter>
+#include <QPen>
+#include <QPolygonF>
+#include <QRectF>
+#include <cmath>
+#include "VmRecord.h" // For formatBytes
+
+// --- CONSTANTS ---
+const int CHART_MIN_HEIGHT = 110;
+const int MARGIN_LEFT = 64;       // Value labels
+const int MARGIN_RIGHT = 8;
+const int MARGIN_TOP = 20;        // Title and legend
+const int MARGIN_BOTTOM = 16;     // Time labels
+const int GRID_LINES = 4;
+const double GAP_FACTOR = 3.0;    // A jump this many times the sample spacing is a gap in the data
+
+MetricChart::MetricChart(const QString& title, Unit unit, QWidget *parent)
+    : QWidget(parent), title(title), unit(unit)
+{
+    setMinimumHeight(CHART_MIN_HEIGHT);
+}
+
+void MetricChart::setLines(const QVector<Line>& newLines)
+{
+    lines.clear();
+    for (const Line& line : newLines) {
+        Line kept = line;
+        kept.points.clear();
+        for (const QPointF& point : line.points) {
+            if (!std::isnan(point.y())) kept.points.append(point);
+        }
+        lines.append(kept);
+    }
+    message.clear();
+    sampledWidth = -1;
+    update();
+}
+
+void MetricChart::setMessage(const QString& text)
+{
+    message = text;
+    update();
+}
+
+QVector<QPointF> MetricChart::downsample(const QVector<QPointF>& points, int threshold)
+{
+    const int n = points.size();
+    if (threshold < 3 || threshold >= n) return points;
+
+    QVector<QPointF> sampled;
+    sampled.reserve(threshold);
+    sampled.append(points[0]);
+
+    // Buckets over points[1 .. n-2]; 'a' is the point kept from the previous bucket
+    const double bucketSize = static_cast<double>(n - 2) / (threshold - 2);
+    int a = 0;
+    for (int bucket = 0; bucket < threshold - 2; ++bucket) {
+        const int start = static_cast<int>(std::floor(bucket * bucketSize)) + 1;
+        const int end = static_cast<int>(std::floor((bucket + 1) * bucketSize)) + 1;
+
+        // Average of the next bucket (the last point for the final one)
+        const int nextStart = end;
+        const int nextEnd = qMin(static_cast<int>(std::floor((bucket + 2) * bucketSize)) + 1, n);
+        double avgX = 0.0, avgY = 0.0;
+        for (int i = nextStart; i < nextEnd; ++i) {
+            avgX += points[i].x();
+            avgY += points[i].y();
+        }
+        const int nextCount = qMax(1, nextEnd - nextStart);
+        avgX /= nextCount;
+        avgY /= nextCount;
+
+        const double ax = points[a].x();
+        const double ay = points[a].y();
+        double maxArea = -1.0;
+        int kept = start;
+        for (int i = start; i < end; ++i) {
+            const double area = std::fabs((ax - avgX) * (points[i].y() - ay) - (ax - points[i].x()) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                kept = i;
+            }
+        }
+        sampled.append(points[kept]);
+        a = kept;
+    }
+
+    sampled.append(points[n - 1]);
+    return sampled;
+}
+
+void MetricChart::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    sampledWidth = -1;   // Resampled on the next paint
+}
+
+void MetricChart::resample()
+{
+    const int plotWidth = qMax(3, width() - MARGIN_LEFT - MARGIN_RIGHT);
+    drawn.clear();
+    maxGapSecs = 0.0;
+    for (const Line& line : lines) {
+        drawn.append(downsample(line.points, plotWidth));
+
+        // Average spacing of the drawn points (never finer than that of the raw data)
+        const QVector<QPointF>& raw = line.points;
+        if (raw.size() >= 2) {
+            const double step = (raw.last().x() - raw.first().x()) / qMin(raw.size() - 1, plotWidth);
+            maxGapSecs = qMax(maxGapSecs, GAP_FACTOR * step);
+        }
+    }
+    sampledWidth = width();
+}
+
+QString MetricChart::formatValue(double value) const
+{
+    switch (unit) {
+        case Unit::Percent:        return QString("%1%").arg(value, 0, 'f', value < 10.0 ? 1 : 0);
+        case Unit::Bytes:          return formatBytes(static_cast<qint64>(value));
+        case Unit::BytesPerSecond: return formatBytes(static_cast<qint64>(value)) + "/s";
+    }
+    return QString::number(value);
+}
+
+// Smallest 1, 2 or 5 times a power of ten that is >= value
+static double niceCeiling(double value)
+{
+    if (value <= 0.0) return 1.0;
+    const double magnitude = std::pow(10.0, std::floor(std::log10(value)));
+    for (double step : {1.0, 2.0, 5.0, 10.0}) {
+        if (step * magnitude >= value) return step * magnitude;
+    }
+    return 10.0 * magnitude;
+}
+
+void MetricChart::paintEvent(QPaintEvent *)
+{
+    if (sampledWidth != width()) resample();
+
+    QPainter painter(this);
+    const QRectF plot(MARGIN_LEFT, MARGIN_TOP, width() - MARGIN_LEFT - MARGIN_RIGHT, height() - MARGIN_TOP - MARGIN_BOTTOM);
+    painter.fillRect(plot, QColor(250, 250, 250));
+
+    // Title, then each line's label and latest value in its color
+    QFontMetrics metrics = painter.fontMetrics();
+    painter.setPen(QColor(Qt::black));
+    painter.drawText(QRectF(4, 0, MARGIN_LEFT + plot.width(), MARGIN_TOP), Qt::AlignLeft | Qt::AlignVCenter, title);
+    double legendX = 4 + metrics.horizontalAdvance(title) + 16;
+    for (int i = 0; i < lines.size(); ++i) {
+        if (drawn[i].isEmpty()) continue;
+        const QString text = QString("%1 %2").arg(lines[i].label).arg(formatValue(drawn[i].last().y()));
+        painter.setPen(lines[i].color);
+        painter.drawText(QRectF(legendX, 0, metrics.horizontalAdvance(text) + 4, MARGIN_TOP), Qt::AlignLeft | Qt::AlignVCenter, text);
+        legendX += metrics.horizontalAdvance(text) + 16;
+    }
+
+    double minX = 0.0, maxX = 0.0, maxY = 0.0;
+    bool any = false;
+    for (const QVector<QPointF>& points : drawn) {
+        for (const QPointF& point : points) {
+            if (!any) {
+                minX = maxX = point.x();
+                any = true;
+            }
+            minX = qMin(minX, point.x());
+            maxX = qMax(maxX, point.x());
+            maxY = qMax(maxY, point.y());
+        }
+    }
+
+    if (!message.isEmpty() || !any) {
+        painter.setPen(QColor(Qt::gray));
+        painter.drawText(plot, Qt::AlignCenter, message.isEmpty() ? QString("No data") : message);
+        return;
+    }
+
+    // Horizontal grid with value labels
+    const double top = niceCeiling(maxY * 1.05);
+    painter.setPen(QColor(225, 225, 225));
+    for (int i = 0; i <= GRID_LINES; ++i) {
+        const double y = plot.bottom() - plot.height() * i / GRID_LINES;
+        painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+    }
+    painter.setPen(QColor(Qt::darkGray));
+    for (int i = 0; i <= GRID_LINES; ++i) {
+        const double y = plot.bottom() - plot.height() * i / GRID_LINES;
+        painter.drawText(QRectF(0, y - metrics.height() / 2.0, MARGIN_LEFT - 4, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter, formatValue(top * i / GRID_LINES));
+    }
+
+    // Time range under the plot
+    const double span = qMax(1.0, maxX - minX);
+    const QString format = span <= 86400 ? "HH:mm" : (span <= 40 * 86400 ? "dd.MM. HH:mm" : "dd.MM.yy");
+    const QRectF timeRow(plot.left(), plot.bottom(), plot.width(), MARGIN_BOTTOM);
+    painter.drawText(timeRow, Qt::AlignLeft | Qt::AlignVCenter,
+                     QDateTime::fromSecsSinceEpoch(static_cast<qint64>(minX)).toString(format));
+    painter.drawText(timeRow, Qt::AlignRight | Qt::AlignVCenter,
+                     QDateTime::fromSecsSinceEpoch(static_cast<qint64>(maxX)).toString(format));
+
+    // The lines, broken where the data has gaps
+    painter.setRenderHint(QPainter::Antialiasing);
+    auto mapPoint = [&](const QPointF& point) {
+        return QPointF(plot.left() + (point.x() - minX) / span * plot.width(),
+                       plot.bottom() - point.y() / top * plot.height());
+    };
+    for (int i = 0; i < drawn.size(); ++i) {
+        painter.setPen(QPen(lines[i].color, 1.5));
+        QPolygonF segment;
+        for (int p = 0; p < drawn[i].size(); ++p) {
+            if (p > 0 && maxGapSecs > 0.0 && drawn[i][p].x() - drawn[i][p - 1].x() > maxGapSecs) {
+                if (segment.size() > 1) painter.drawPolyline(segment);
+                segment.clear();
+            }
+            segment.append(mapPoint(drawn[i][p]));
+        }
+        if (segment.size() > 1) painter.drawPolyline(segment);
+    }
+}
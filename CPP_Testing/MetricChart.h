@@ -0,0 +1,57 @@
+#ifndef METRICCHART_H
+#define METRICCHART_H
+
+#include <QColor>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <QWidget>
+
+// --- MetricChart ---
+// Small custom-painted line chart for one metric (one or two lines over time).
+// Lines are reduced with Largest-Triangle-Three-Buckets to about one point per pixel
+// of plot width whenever the data or the width changes, so painting a year of samples
+// costs the same as painting a few minutes. Gaps in the data (NaN values, or a jump
+// in time much longer than the sample spacing) are drawn as breaks in the line.
+class MetricChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum class Unit { Percent, Bytes, BytesPerSecond };
+
+    struct Line
+    {
+        QString label;
+        QColor color;
+        QVector<QPointF> points;   // x: seconds since the epoch (ascending), y: value; NaN y = no data
+    };
+
+    explicit MetricChart(const QString& title, Unit unit, QWidget *parent = nullptr);
+
+    void setLines(const QVector<Line>& lines);
+    void setMessage(const QString& message);   // Replaces the plot with a line of text ("Loading...")
+
+    // Largest-Triangle-Three-Buckets: keeps the first and last point and, from each of
+    // threshold - 2 equal buckets in between, the point forming the largest triangle
+    // with the previously kept point and the next bucket's average.
+    static QVector<QPointF> downsample(const QVector<QPointF>& points, int threshold);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QString formatValue(double value) const;
+    void resample();
+
+    QString title;
+    Unit unit;
+    QString message;
+    QVector<Line> lines;               // As given, NaN rows removed
+    QVector<QVector<QPointF>> drawn;   // Downsampled for the current plot width
+    double maxGapSecs = 0.0;           // Longer jumps between drawn points are breaks
+    int sampledWidth = -1;
+};
+
+#endif // METRICCHART_H
@@ -0,0 +1,436 @@
+#include "MetricsHistory.h"
+#include <QElapsedTimer>
+#include <cstring>
+#include "ProxmoxApiManager.h" // For Vm struct
+
+// --- CONSTANTS ---
+const int FIRST_DELTA_BITS = 14;      // Second sample of a block: plain delta (blocks span < 2^14 s)
+const quint8 NO_WINDOW = 0xFF;        // No XOR window yet: the next changed value writes its own
+const int MAX_LEADING_ZEROS = 31;     // Stored in 5 bits
+
+// --- BitStream ---
+
+void BitStream::write(quint64 value, int count)
+{
+    if (count < 64) value &= (quint64(1) << count) - 1;
+    const int used = bits & 63;
+    if (used == 0) words.push_back(0);
+
+    const int space = 64 - used;
+    if (count <= space) {
+        words.back() |= value << (space - count);
+    } else {
+        const int rest = count - space;
+        words.back() |= value >> rest;
+        words.push_back(value << (64 - rest));
+    }
+    bits += count;
+}
+
+quint64 BitStream::read(quint32& cursor, int count) const
+{
+    const quint64 word = words[cursor >> 6];
+    const int used = cursor & 63;
+    const int available = 64 - used;
+    quint64 result;
+    if (count <= available) {
+        result = (word << used) >> (64 - count);
+    } else {
+        const int rest = count - available;
+        result = ((word << used) >> used) << rest | words[(cursor >> 6) + 1] >> (64 - rest);
+    }
+    cursor += count;
+    return result;
+}
+
+// --- ENCODING HELPERS ---
+
+static quint64 doubleBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Two's complement field of 'count' bits back to a signed value
+static qint64 signExtend(quint64 value, int count)
+{
+    const quint64 sign = quint64(1) << (count - 1);
+    return static_cast<qint64>((value ^ sign) - sign);
+}
+
+/**
+ * @brief Delta-of-delta of a timestamp: '0' for a regular interval, otherwise a prefix
+ * selecting a 7, 9, 12 or 32-bit two's complement field (Gorilla's ranges, shifted by
+ * one so they are exactly the signed field's range).
+ */
+static void writeDeltaOfDelta(BitStream& out, qint64 dod)
+{
+    if (dod == 0) {
+        out.write(0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        out.write(0b10, 2);
+        out.write(static_cast<quint64>(dod), 7);
+    } else if (dod >= -256 && dod <= 255) {
+        out.write(0b110, 3);
+        out.write(static_cast<quint64>(dod), 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        out.write(0b1110, 4);
+        out.write(static_cast<quint64>(dod), 12);
+    } else {
+        out.write(0b1111, 4);
+        out.write(static_cast<quint64>(dod), 32);
+    }
+}
+
+static qint64 readDeltaOfDelta(const BitStream& in, quint32& cursor)
+{
+    if (in.read(cursor, 1) == 0) return 0;
+    if (in.read(cursor, 1) == 0) return signExtend(in.read(cursor, 7), 7);
+    if (in.read(cursor, 1) == 0) return signExtend(in.read(cursor, 9), 9);
+    if (in.read(cursor, 1) == 0) return signExtend(in.read(cursor, 12), 12);
+    return signExtend(in.read(cursor, 32), 32);
+}
+
+/**
+ * @brief A value XORed with the previous one: '0' if unchanged; '10' + the changed bits
+ * if they fit the previous leading/trailing-zero window; otherwise '11', 5 bits of
+ * leading zeros, 6 bits of length (64 stored as 0) and the changed bits, which opens a
+ * new window.
+ */
+static void writeXor(BitStream& out, quint64 bits, quint64& lastBits, quint8& leading, quint8& trailing)
+{
+    const quint64 x = bits ^ lastBits;
+    lastBits = bits;
+    if (x == 0) {
+        out.write(0, 1);
+        return;
+    }
+
+    const int lead = qMin<int>(MAX_LEADING_ZEROS, qCountLeadingZeroBits(x));
+    const int trail = qCountTrailingZeroBits(x);
+    if (leading != NO_WINDOW && lead >= leading && trail >= trailing) {
+        out.write(0b10, 2);
+        out.write(x >> trailing, 64 - leading - trailing);
+        return;
+    }
+
+    const int length = 64 - lead - trail;
+    out.write(0b11, 2);
+    out.write(static_cast<quint64>(lead), 5);
+    out.write(static_cast<quint64>(length & 63), 6);
+    out.write(x >> trail, length);
+    leading = static_cast<quint8>(lead);
+    trailing = static_cast<quint8>(trail);
+}
+
+static quint64 readXor(const BitStream& in, quint32& cursor, quint64 lastBits, int& leading, int& trailing)
+{
+    if (in.read(cursor, 1) == 0) return lastBits;
+    if (in.read(cursor, 1) == 1) {
+        leading = static_cast<int>(in.read(cursor, 5));
+        int length = static_cast<int>(in.read(cursor, 6));
+        if (length == 0) length = 64;
+        trailing = 64 - leading - length;
+    }
+    return lastBits ^ (in.read(cursor, 64 - leading - trailing) << trailing);
+}
+
+// --- MetricsHistory ---
+
+MetricsHistory::MetricsHistory(int retentionSecs, int blockSecs)
+    : retentionSecs(qMax(1, retentionSecs)),
+      blockSecs(qBound(60, blockSecs, (1 << FIRST_DELTA_BITS) - 1))
+{
+    ringSize = (this->retentionSecs + this->blockSecs - 1) / this->blockSecs + 1;
+}
+
+QString MetricsHistory::metricName(Metric metric)
+{
+    switch (metric) {
+        case Cpu:       return "cpu";
+        case Mem:       return "mem";
+        case MaxMem:    return "maxmem";
+        case Disk:      return "disk";
+        case NetIn:     return "netin";
+        case NetOut:    return "netout";
+        case DiskRead:  return "diskread";
+        case DiskWrite: return "diskwrite";
+        default:        return QString();
+    }
+}
+
+void MetricsHistory::record(const QVector<Vm>& vms, qint64 time)
+{
+    double values[MetricCount];
+    for (const Vm& vm : vms) {
+        // CPU at float precision (as in VmInventory): the low 29 mantissa bits stay zero,
+        // which roughly halves its XOR cost; the other metrics are whole numbers
+        values[Cpu] = static_cast<float>(vm.cpu);
+        values[Mem] = static_cast<double>(vm.mem);
+        values[MaxMem] = static_cast<double>(vm.maxmem);
+        values[Disk] = static_cast<double>(vm.disk);
+        values[NetIn] = static_cast<double>(vm.netin);
+        values[NetOut] = static_cast<double>(vm.netout);
+        values[DiskRead] = static_cast<double>(vm.diskread);
+        values[DiskWrite] = static_cast<double>(vm.diskwrite);
+        record(vm.vmid, time, values);
+    }
+
+    // Guests gone for a whole retention period (deleted, or on another cluster) are dropped
+    for (auto it = series.begin(); it != series.end();) {
+        const Series& s = it.value();
+        if (s.head >= 0 && s.blocks[s.head].lastTime < time - retentionSecs) {
+            it = series.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MetricsHistory::record(int vmid, qint64 time, const double (&values)[MetricCount])
+{
+    Series& s = series[vmid];
+    if (s.head >= 0) {
+        const Block& head = s.blocks[s.head];
+        if (time <= head.lastTime) return;
+        if (time - head.firstTime >= blockSecs) startBlock(s, time);
+    } else {
+        startBlock(s, time);
+    }
+    appendSample(s.blocks[s.head], s, time, values);
+}
+
+// Closes the head block (if any) and moves the head to a fresh or recycled block
+void MetricsHistory::startBlock(Series& s, qint64 time)
+{
+    if (s.head >= 0) s.blocks[s.head].bits.shrink();
+
+    if (static_cast<int>(s.blocks.size()) < ringSize) {
+        if (s.blocks.empty()) s.blocks.reserve(ringSize);
+        s.blocks.emplace_back();
+        s.head = static_cast<int>(s.blocks.size()) - 1;
+    } else {
+        s.head = (s.head + 1) % ringSize;
+    }
+
+    Block& block = s.blocks[s.head];
+    block.bits.clear();
+    block.firstTime = time;
+    block.lastTime = time;
+    block.count = 0;
+}
+
+/**
+ * @brief Sample layout: the first of a block is its time (in firstTime) and raw values;
+ * the second adds a plain delta; later ones a delta-of-delta. Each is followed by one
+ * XOR-encoded value per metric, in Metric order.
+ */
+void MetricsHistory::appendSample(Block& block, Series& s, qint64 time, const double (&values)[MetricCount])
+{
+    BitStream& out = block.bits;
+    if (block.count == 0) {
+        for (int m = 0; m < MetricCount; ++m) {
+            s.lastBits[m] = doubleBits(values[m]);
+            s.leading[m] = NO_WINDOW;
+            s.trailing[m] = 0;
+            out.write(s.lastBits[m], 64);
+        }
+    } else {
+        const qint64 delta = time - block.lastTime;
+        if (block.count == 1) {
+            out.write(static_cast<quint64>(delta), FIRST_DELTA_BITS);
+        } else {
+            writeDeltaOfDelta(out, delta - s.lastDelta);
+        }
+        s.lastDelta = delta;
+        for (int m = 0; m < MetricCount; ++m) {
+            writeXor(out, doubleBits(values[m]), s.lastBits[m], s.leading[m], s.trailing[m]);
+        }
+    }
+    block.lastTime = time;
+    block.count++;
+}
+
+// Calls visit(time, values) for every sample of the block, oldest first
+template<class F>
+void MetricsHistory::decode(const Block& block, F visit)
+{
+    const BitStream& in = block.bits;
+    quint32 cursor = 0;
+    qint64 time = block.firstTime;
+    qint64 delta = 0;
+    quint64 bits[MetricCount];
+    int leading[MetricCount];
+    int trailing[MetricCount];
+    double values[MetricCount];
+
+    for (int i = 0; i < block.count; ++i) {
+        if (i == 0) {
+            for (int m = 0; m < MetricCount; ++m) {
+                bits[m] = in.read(cursor, 64);
+                leading[m] = 0;
+                trailing[m] = 0;
+            }
+        } else {
+            delta = (i == 1) ? static_cast<qint64>(in.read(cursor, FIRST_DELTA_BITS)) : delta + readDeltaOfDelta(in, cursor);
+            time += delta;
+            for (int m = 0; m < MetricCount; ++m) {
+                bits[m] = readXor(in, cursor, bits[m], leading[m], trailing[m]);
+            }
+        }
+        for (int m = 0; m < MetricCount; ++m) values[m] = bitsDouble(bits[m]);
+        visit(time, values);
+    }
+}
+
+QVector<MetricsHistory::Sample> MetricsHistory::range(int vmid, Metric metric, qint64 from, qint64 to) const
+{
+    QVector<Sample> result;
+    auto it = series.constFind(vmid);
+    if (it == series.constEnd() || metric < 0 || metric >= MetricCount) return result;
+
+    // Oldest block first: once the ring has wrapped it is the one after the head
+    const Series& s = it.value();
+    const int blockCount = static_cast<int>(s.blocks.size());
+    const int oldest = (blockCount < ringSize) ? 0 : (s.head + 1) % ringSize;
+    for (int i = 0; i < blockCount; ++i) {
+        const Block& block = s.blocks[(oldest + i) % blockCount];
+        if (block.count == 0 || block.lastTime < from || block.firstTime > to) continue;
+        decode(block, [&result, metric, from, to](qint64 time, const double *values) {
+            if (time >= from && time <= to) result.append(Sample{time, values[metric]});
+        });
+    }
+    return result;
+}
+
+qint64 MetricsHistory::sampleCount() const
+{
+    qint64 total = 0;
+    for (const Series& s : series) {
+        for (const Block& block : s.blocks) total += block.count;
+    }
+    return total;
+}
+
+qint64 MetricsHistory::bytes() const
+{
+    qint64 total = 0;
+    for (const Series& s : series) {
+        total += sizeof(Series) + static_cast<qint64>(s.blocks.capacity()) * sizeof(Block);
+        for (const Block& block : s.blocks) total += block.bits.bytes();
+    }
+    // One hash node per guest: key, value and the hash/next bookkeeping
+    total += static_cast<qint64>(series.size()) * (sizeof(int) + 2 * sizeof(void*));
+    return total;
+}
+
+// --- BENCHMARK ---
+
+QString MetricsHistory::benchmark(int vms, int hours, int intervalSecs)
+{
+    const qint64 GIB = qint64(1) << 30;
+    const qint64 PAGE = 4096;
+    const qint64 START = 1700000000;
+    const int rounds = hours * 3600 / qMax(1, intervalSecs);
+
+    // Deterministic pseudo-random cluster: ~70% running, a third of those idle
+    struct Guest
+    {
+        bool running = false;
+        bool busy = false;
+        float cpu = 0.0f;
+        qint64 mem = 0, maxmem = 0, disk = 0;
+        qint64 netin = 0, netout = 0, diskread = 0, diskwrite = 0;
+    };
+    quint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    std::vector<Guest> guests(vms);
+    for (Guest& g : guests) {
+        g.running = next() % 10 < 7;
+        g.busy = g.running && next() % 3 != 0;
+        g.maxmem = (1 + next() % 16) * GIB;
+        g.mem = g.running ? (g.maxmem / 2 / PAGE) * PAGE : 0;
+        g.disk = (next() % 4 == 0) ? (1 + next() % 32) * GIB : 0;   // Containers report usage
+    }
+
+    MetricsHistory history(hours * 3600);
+    const int checkedVm = 0;
+    QVector<Sample> expected;   // Cpu and NetIn of guest 0, to verify the round trip
+    QVector<Sample> expectedNet;
+    double values[MetricCount];
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 time = START;
+    for (int round = 0; round < rounds; ++round) {
+        time += intervalSecs + ((next() % 16 == 0) ? 1 : 0);   // Occasional late poll
+        for (int i = 0; i < vms; ++i) {
+            Guest& g = guests[i];
+            if (g.busy) {
+                g.cpu = qBound(0.0f, g.cpu + (static_cast<int>(next() % 201) - 100) / 5000.0f, 1.0f);
+                g.mem = qBound(PAGE, g.mem + (static_cast<qint64>(next() % 2001) - 1000) * PAGE, g.maxmem);
+                g.netin += next() % 200000;
+                g.netout += next() % 50000;
+                g.diskread += (next() % 4 == 0) ? (next() % 256) * PAGE : 0;
+                g.diskwrite += (next() % 2 == 0) ? (next() % 64) * PAGE : 0;
+            }
+            values[Cpu] = g.cpu;
+            values[Mem] = static_cast<double>(g.mem);
+            values[MaxMem] = static_cast<double>(g.maxmem);
+            values[Disk] = static_cast<double>(g.disk);
+            values[NetIn] = static_cast<double>(g.netin);
+            values[NetOut] = static_cast<double>(g.netout);
+            values[DiskRead] = static_cast<double>(g.diskread);
+            values[DiskWrite] = static_cast<double>(g.diskwrite);
+            history.record(100 + i, time, values);
+            if (i == checkedVm) {
+                expected.append(Sample{time, values[Cpu]});
+                expectedNet.append(Sample{time, values[NetIn]});
+            }
+        }
+    }
+    const qint64 recordNs = timer.nsecsElapsed();
+
+    // Read back the last hour of one metric for up to 1000 guests
+    const int readers = qMin(vms, 1000);
+    timer.restart();
+    qint64 readSamples = 0;
+    for (int i = 0; i < readers; ++i) {
+        readSamples += history.range(100 + i, Cpu, time - 3600, time).size();
+    }
+    const qint64 readNs = timer.nsecsElapsed();
+
+    bool verified = vms > 0;
+    if (verified) {
+        const QVector<Sample> cpu = history.range(100 + checkedVm, Cpu, START, time);
+        const QVector<Sample> net = history.range(100 + checkedVm, NetIn, START, time);
+        verified = cpu.size() == expected.size() && net.size() == expectedNet.size();
+        for (int i = 0; verified && i < cpu.size(); ++i) {
+            verified = cpu[i].time == expected[i].time && cpu[i].value == expected[i].value
+                    && net[i].value == expectedNet[i].value;
+        }
+    }
+
+    const qint64 samples = history.sampleCount();
+    const qint64 bytes = history.bytes();
+    const double rawPerSample = sizeof(qint64) + MetricCount * sizeof(double);   // Time plus 8 doubles
+    const double perSample = samples > 0 ? static_cast<double>(bytes) / samples : 0.0;
+    return QString("Metrics history benchmark, %1 guests x %2 metrics x %3 h at %4 s: %5 samples (one per guest and poll) in %6 MiB, "
+                   "%7 bytes/sample vs %8 uncompressed (%9x); record %10 us/poll; 1 h read %11 us/series (%12 samples); round trip %13")
+        .arg(vms).arg(static_cast<int>(MetricCount)).arg(hours).arg(intervalSecs)
+        .arg(samples).arg(bytes / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(perSample, 0, 'f', 2).arg(rawPerSample, 0, 'f', 0)
+        .arg(perSample > 0 ? rawPerSample / perSample : 0.0, 0, 'f', 1)
+        .arg(rounds > 0 ? recordNs / 1000.0 / rounds : 0.0, 0, 'f', 0)
+        .arg(readers > 0 ? readNs / 1000.0 / readers : 0.0, 0, 'f', 1)
+        .arg(readers > 0 ? readSamples / readers : 0)
+        .arg(verified ? "ok" : "MISMATCH");
+}
@@ -0,0 +1,100 @@
+#ifndef METRICSHISTORY_H
+#define METRICSHISTORY_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+struct Vm;
+
+// --- BitStream ---
+// Append-only bit buffer, most significant bit first. Readers keep their own cursor.
+class BitStream
+{
+public:
+    void write(quint64 value, int count);                  // Low 'count' bits of value, 1 <= count <= 64
+    quint64 read(quint32& cursor, int count) const;        // 'count' bits at cursor; advances it
+    quint32 size() const { return bits; }
+
+    void clear() { words.clear(); bits = 0; }   // Keeps the capacity for reuse
+    void shrink() { words.shrink_to_fit(); }
+    qint64 bytes() const { return static_cast<qint64>(words.capacity()) * sizeof(quint64); }
+
+private:
+    std::vector<quint64> words;
+    quint32 bits = 0;
+};
+
+// --- MetricsHistory ---
+// Short-term history of every guest's usage figures, fed from each VM list poll.
+// Samples are compressed as in Facebook's Gorilla TSDB: timestamps as delta-of-deltas
+// (a regular poll costs one bit) and values XORed with the previous one (an unchanged
+// value costs one bit, a slowly moving one only its changed middle bits). The metrics
+// of one guest share a timestamp and are interleaved in one stream per block.
+// Each guest has a ring of fixed-span blocks; once the ring is full the oldest block is
+// reused, so memory stays bounded by retention and poll rate. Not thread-safe.
+class MetricsHistory
+{
+public:
+    enum Metric { Cpu, Mem, MaxMem, Disk, NetIn, NetOut, DiskRead, DiskWrite, MetricCount };
+
+    struct Sample
+    {
+        qint64 time;    // Seconds since the epoch
+        double value;
+    };
+
+    explicit MetricsHistory(int retentionSecs = 4 * 60 * 60, int blockSecs = 30 * 60);
+
+    // Appends one sample per guest at 'time'. Samples not newer than a guest's last one
+    // are dropped; guests that have not reported for a whole retention period are forgotten.
+    void record(const QVector<Vm>& vms, qint64 time);
+    void record(int vmid, qint64 time, const double (&values)[MetricCount]);
+    void clear() { series.clear(); }
+
+    // Samples of one metric with from <= time <= to, oldest first (empty for unknown guests)
+    QVector<Sample> range(int vmid, Metric metric, qint64 from, qint64 to) const;
+
+    int seriesCount() const { return series.size(); }
+    qint64 sampleCount() const;
+    qint64 bytes() const;   // Heap used by the blocks, the encoder state and the index (approximate)
+
+    static QString metricName(Metric metric);
+
+    // Feeds 'vms' synthetic guests for 'hours' at one sample per 'intervalSecs', reads one
+    // series back to check the round trip, and returns a memory and timing summary line.
+    static QString benchmark(int vms, int hours, int intervalSecs);
+
+private:
+    struct Block
+    {
+        qint64 firstTime = 0;
+        qint64 lastTime = 0;
+        int count = 0;
+        BitStream bits;
+    };
+
+    struct Series
+    {
+        std::vector<Block> blocks;   // Ring; 'head' is the block being appended to
+        int head = -1;
+        // Encoder state of the head block
+        qint64 lastDelta = 0;
+        quint64 lastBits[MetricCount] = {};
+        quint8 leading[MetricCount] = {};
+        quint8 trailing[MetricCount] = {};
+    };
+
+    void startBlock(Series& s, qint64 time);
+    void appendSample(Block& block, Series& s, qint64 time, const double (&values)[MetricCount]);
+    template<class F> static void decode(const Block& block, F visit);
+
+    int retentionSecs;
+    int blockSecs;
+    int ringSize;                 // Blocks per guest: enough to always cover the retention period
+    QHash<int, Series> series;    // vmid -> history
+};
+
+#endif // METRICSHISTORY_H
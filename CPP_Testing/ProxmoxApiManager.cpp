@@ -1,189 +1,294 @@
 #include "ProxmoxApiManager.h"
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <algorithm>
-#include <iomanip>
+#include <set>
 #include <stdexcept>
 #include <QDebug> // For internal logging/debugging
 #include <QStringList>
+#include <QUrl>
 #include <curl/curl.h>
+#include "CurlConnectionPool.h"
+#include "VmResourceSaxParser.h"
+#include "InventoryCache.h"
+#include "EndpointSelector.h"
+#include "TaskTracker.h"
+#include "Tracing.h"
 
 // --- CONSTANTS ---
 const int PROXMOX_PORT = 8006;
 const bool VERIFY_SSL = false; 
-const std::string VM_FOLDERS_FILE = "vm_folders.json"; 
+const std::string VM_FOLDERS_FILE = "vm_folders.json";   // Legacy format, migrated on first load
+const std::string VM_FOLDERS_SNAPSHOT_FILE = "vm_folders.bin";
+const std::string VM_FOLDERS_JOURNAL_FILE = "vm_folders.journal";
+const std::string INVENTORY_CACHE_FILE = "inventory_cache.bin";
+const qint64 TICKET_LIFETIME_SECS = 2 * 60 * 60;   // Fixed by the PVE server
+const qint64 TICKET_RENEW_AFTER_SECS = 90 * 60;    // Leaves 30 minutes for retries
+const int TICKET_RETRY_SECS = 60;
+const int MAX_ACTIONS_PER_NODE = 4;     // Concurrent power-action POSTs per node during bulk actions
+const qint64 INVENTORY_SAVE_INTERVAL_MS = 60 * 1000;   // The list is polled every few seconds; the cache needn't be
+
+// Form values must be percent-encoded: tickets contain '+', '/' and '=', and passwords may too
+static std::string formEncode(const std::string& value)
+{
+    return QUrl::toPercentEncoding(QString::fromStdString(value)).toStdString();
+}
 
-// --- HELPER FUNCTION FOR CURL (std::string based, same as original) ---
+// --- CONSTRUCTOR & SLOTS (Qt Integration) ---
 
-/**
- * @brief Callback function for libcurl to write received data into a std::string.
- */
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+ProxmoxApiManager::ProxmoxApiManager(QObject *parent)
+    : QObject(parent),
+      folderStore(QString::fromStdString(VM_FOLDERS_SNAPSHOT_FILE), QString::fromStdString(VM_FOLDERS_JOURNAL_FILE),
+                  QString::fromStdString(VM_FOLDERS_FILE))
 {
-    ((std::string *)userp)->append((char *)contents, size * nmemb);
-    return size * nmemb;
+    // All HTTP traffic runs on the engine's network thread; callbacks come back here
+    requestEngine = new ApiRequestEngine(this);
+    
+    // Which cluster node receives requests (the host field may list several)
+    endpoints = new EndpointSelector(requestEngine, PROXMOX_PORT, VERIFY_SSL, this);
+    connect(endpoints, &EndpointSelector::statusChanged, this, &ProxmoxApiManager::endpointStatusChanged);
+    
+    // Task status polls bypass the GET freshness window
+    tasks = new TaskTracker([this](const std::string& path, std::function<void(const std::string&)> onDone) {
+        proxmox_get(path, onDone, false);
+    }, this);
+    connect(tasks, &TaskTracker::taskFinished, this, &ProxmoxApiManager::handleTaskFinished);
+    
+    // RRD rows only change once per step; RrdFetcher keeps its own, longer-lived cache
+    rrd = new RrdFetcher([this](const std::string& path, std::function<void(const std::string&)> onDone) {
+        proxmox_get(path, onDone, false);
+    }, this);
+    connect(rrd, &RrdFetcher::ready, this, &ProxmoxApiManager::rrdDataReady);
+    
+    // Child object: moves to the manager's thread together with us
+    ticketRenewalTimer = new QTimer(this);
+    ticketRenewalTimer->setSingleShot(true);
+    connect(ticketRenewalTimer, &QTimer::timeout, this, &ProxmoxApiManager::renewTicket);
 }
 
-// --- LOCAL PERSISTENCE FUNCTIONS (Adapted from original) ---
-
 /**
- * @brief Loads the VM folder mapping from a local JSON file.
- * @return A map where key is VMID and value is the folder name.
+ * @brief Loads local data. Invoked once the manager's thread has started, so the
+ * file read does not happen on the GUI thread.
  */
-std::map<int, std::string> ProxmoxApiManager::load_vm_folders() {
-    std::map<int, std::string> folders;
-    std::ifstream i(VM_FOLDERS_FILE);
-    if (i.is_open()) {
-        try {
-            json j;
-            i >> j;
-            if (j.is_object()) {
-                for (auto it = j.begin(); it != j.end(); ++it) {
-                    try {
-                        int vmid = std::stoi(it.key());
-                        folders[vmid] = it.value().get<std::string>();
-                    } catch (const std::exception& e) {
-                        qWarning() << "Warning: Skipping invalid entry in folder file:" << QString::fromStdString(it.key());
-                    }
-                }
-            }
-            qInfo() << "Loaded" << folders.size() << "VM folder assignments from" << QString::fromStdString(VM_FOLDERS_FILE);
-        } catch (const json::parse_error& e) {
-            qWarning() << "Warning: Could not parse" << QString::fromStdString(VM_FOLDERS_FILE) << ". Starting with no folder assignments.";
+void ProxmoxApiManager::initialize()
+{
+    std::map<int, std::string> folders = folderStore.load();
+    if (!folderStore.loadWarning().isEmpty()) emit folderStoreWarning(folderStore.loadWarning());
+
+    // Last-known inventory, so the window has something to show before the first fetch
+    InventoryCache::Snapshot cached;
+    bool haveCache = InventoryCache::load(QString::fromStdString(INVENTORY_CACHE_FILE), cached);
+
+    QMutexLocker locker(&state_mutex);
+    vm_folders_std = std::move(folders);
+    if (haveCache) {
+        // Folder assignments may have changed after the cache was written
+        for (Vm& vm : cached.vms) {
+            auto folder_it = vm_folders_std.find(vm.vmid);
+            vm.folder = (folder_it != vm_folders_std.end()) ? QString::fromStdString(folder_it->second) : QString("Unassigned");
         }
-        i.close();
-    } else {
-        qInfo() << "Folder configuration file (" << QString::fromStdString(VM_FOLDERS_FILE) << ") not found. Starting fresh.";
     }
-    return folders;
+    locker.unlock();
+
+    if (haveCache) {
+        qInfo() << "Loaded" << cached.vms.size() << "cached guests of" << cached.host << "saved" << cached.savedAt.toString(Qt::ISODate);
+        emit cachedVmListReady(cached.vms, cached.host, cached.savedAt);
+    }
 }
 
 /**
- * @brief Saves the current VM folder mapping to a local JSON file.
+ * @brief Returns the locally stored folder for a VMID ("Unassigned" if none). Thread-safe.
  */
-void ProxmoxApiManager::save_vm_folders(const std::map<int, std::string>& folders) {
-    json j;
-    for (const auto& pair : folders) {
-        j[std::to_string(pair.first)] = pair.second;
+QString ProxmoxApiManager::getVmFolder(int vmid) const
+{
+    QMutexLocker locker(&state_mutex);
+    auto it = vm_folders_std.find(vmid);
+    return (it != vm_folders_std.end()) ? QString::fromStdString(it->second) : QString("Unassigned");
+}
+
+ProxmoxApiManager::~ProxmoxApiManager()
+{
+    // Stop the network thread before our members (used by pending callbacks) go away
+    requestEngine->shutdown();
+    
+    // Write out queued folder assignments and fold the journal into the snapshot
+    folderStore.close();
+}
+
+/**
+ * @brief Performs a generic authenticated GET request to the Proxmox API.
+ * The callback receives the response body, or an empty string on failure.
+ *
+ * Identical GETs are single-flighted: if the same path is already in flight, the
+ * caller is attached to that request instead of issuing another one. A successful
+ * response is also reused for get_freshness_ms afterwards, unless the request was
+ * issued with allowFresh = false (one-off paths such as task status or RRD data,
+ * whose bodies would otherwise pile up in fresh_gets). With joinInFlight = false a
+ * new request is always sent, for callers that need state newer than any request
+ * already under way; later callers then attach to the new one.
+ */
+void ProxmoxApiManager::proxmox_get(const std::string& path, std::function<void(const std::string&)> onDone, bool allowFresh, bool joinInFlight)
+{
+    // 1. Serve from the freshness window (still asynchronously, like a real request)
+    auto fresh_it = fresh_gets.find(path);
+    if (fresh_it != fresh_gets.end()) {
+        if (allowFresh && get_freshness_ms > 0 && !fresh_it->second.age.hasExpired(get_freshness_ms)) {
+            gets_served_fresh++;
+            std::string body = fresh_it->second.body;
+            QMetaObject::invokeMethod(this, [onDone, body]() { onDone(body); }, Qt::QueuedConnection);
+            return;
+        }
+        fresh_gets.erase(fresh_it);
     }
 
-    std::ofstream o(VM_FOLDERS_FILE);
-    if (o.is_open()) {
-        o << std::setw(4) << j << std::endl;
-        qInfo() << "Saved" << folders.size() << "VM folder assignments to" << QString::fromStdString(VM_FOLDERS_FILE);
-        o.close();
-    } else {
-        qCritical() << "Error: Could not open" << QString::fromStdString(VM_FOLDERS_FILE) << "for writing.";
+    // 2. Attach to an identical request already in flight
+    auto inflight_it = inflight_gets.find(path);
+    if (joinInFlight && inflight_it != inflight_gets.end()) {
+        gets_coalesced++;
+        inflight_it->second->push_back(onDone);
+        return;
     }
-}
 
+    // 3. Issue a new request
+    renewTicketIfDue();
+    GetWaiters waiters = std::make_shared<std::vector<GetCallback>>();
+    waiters->push_back(onDone);
+    inflight_gets[path] = waiters;
+    gets_issued++;
 
-// --- CONSTRUCTOR & SLOTS (Qt Integration) ---
+    submit_get(path, waiters, QStringList(), allowFresh);
+}
 
-ProxmoxApiManager::ProxmoxApiManager(QObject *parent)
-    : QObject(parent)
+/**
+ * @brief Sends a GET to the selected endpoint. GETs are idempotent, so if the node
+ * itself fails (connection error, proxy error) the request is repeated on the next
+ * best endpoint that has not been tried yet.
+ */
+void ProxmoxApiManager::submit_get(const std::string& path, GetWaiters waiters, QStringList tried, bool keepFresh)
 {
-    // Load local data on initialization
-    vm_folders_std = load_vm_folders();
+    QString endpoint = endpoints->select(tried);
+    tried.append(endpoint);
+
+    ApiRequest request;
+    prepare_request(path, request, endpoint);
+
+    requestEngine->submit(request, this, [this, path, waiters, tried, endpoint, keepFresh](const ApiResponse& response) {
+        endpoints->reportResult(endpoint, response);
+        if (EndpointSelector::isTransportFailure(response)) {
+            QString next = endpoints->select(tried);
+            if (!next.isEmpty()) {
+                qInfo() << "GET" << QString::fromStdString(path) << "failed on" << endpoint << "- retrying on" << next;
+                gets_retried++;
+                submit_get(path, waiters, tried, keepFresh);
+                return;
+            }
+        }
+
+        // Only the current flight owns the map entry; an invalidated one must not clobber its successor
+        auto it = inflight_gets.find(path);
+        bool current = (it != inflight_gets.end() && it->second == waiters);
+        if (current) inflight_gets.erase(it);
+
+        std::string body;
+        if (!response.ok()) {
+            qWarning() << "CURL Error (GET" << QString::fromStdString(path) << "):" << curl_easy_strerror(response.curlCode) << "(HTTP:" << response.httpCode << ")";
+        } else {
+            body = response.body;
+            if (current && keepFresh && get_freshness_ms > 0) {
+                prune_fresh_gets();
+                CachedGet& cached = fresh_gets[path];
+                cached.age.start();
+                cached.body = body;
+            }
+        }
+
+        for (const GetCallback& callback : *waiters) {
+            callback(body);
+        }
+    });
 }
 
 /**
- * @brief Performs a generic authenticated GET request to the Proxmox API.
+ * @brief Drops expired fresh_gets entries, so paths that are never requested again
+ * don't keep their bodies for the rest of the session.
  */
-std::string ProxmoxApiManager::proxmox_get(const std::string& path) const
+void ProxmoxApiManager::prune_fresh_gets()
 {
-    CURL *curl;
-    CURLcode res;
-    std::string readBuffer;
-    
-    std::string host_std = host_qt.toStdString();
-    std::string auth_cookie_std = auth_cookie_qt.toStdString();
-    std::string csrf_token_std = csrf_token_qt.toStdString();
-    
-    std::string url = "https://" + host_std + ":" + std::to_string(PROXMOX_PORT) + "/api2/json" + path;
-    
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-        if (!VERIFY_SSL) {
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    for (auto it = fresh_gets.begin(); it != fresh_gets.end();) {
+        if (it->second.age.hasExpired(get_freshness_ms)) {
+            it = fresh_gets.erase(it);
+        } else {
+            ++it;
         }
+    }
+}
 
-        struct curl_slist *headers = NULL;
-        std::string cookie_header = "Cookie: " + auth_cookie_std;
-        std::string csrf_header = "CSRFPreventionToken: " + csrf_token_std;
-        
-        headers = curl_slist_append(headers, cookie_header.c_str());
-        headers = curl_slist_append(headers, csrf_header.c_str());
-        headers = curl_slist_append(headers, "Accept: application/json");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-        res = curl_easy_perform(curl);
-        
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-
-        if (res != CURLE_OK || http_code != 200) {
-            qWarning() << "CURL Error (GET" << QString::fromStdString(path) << "):" << curl_easy_strerror(res) << "(HTTP:" << http_code << ")";
-            return ""; 
-        }
+/**
+ * @brief Fills in the URL and authentication headers for an API path, from one
+ * consistent snapshot of the session state.
+ * Ticket sessions send the cookie and CSRF token; API tokens need neither and
+ * authenticate every request with a single Authorization header.
+ */
+void ProxmoxApiManager::prepare_request(const std::string& path, ApiRequest& request, const QString& endpoint) const
+{
+    QMutexLocker locker(&state_mutex);
+    request.url = "https://" + endpoint.toStdString() + ":" + std::to_string(PROXMOX_PORT) + "/api2/json" + path;
+    request.verifySsl = VERIFY_SSL;
+    if (auth_mode == AuthMode::ApiToken) {
+        request.headers.push_back("Authorization: PVEAPIToken=" + api_token_qt.toStdString());
+    } else {
+        request.headers.push_back("Cookie: " + auth_cookie_qt.toStdString());
+        request.headers.push_back("CSRFPreventionToken: " + csrf_token_qt.toStdString());
     }
-    return readBuffer;
+    request.headers.push_back("Accept: application/json");
+}
+
+bool ProxmoxApiManager::isAuthenticated() const
+{
+    QMutexLocker locker(&state_mutex);
+    if (auth_mode == AuthMode::ApiToken) return !api_token_qt.isEmpty();
+    return !auth_cookie_qt.isEmpty() && !csrf_token_qt.isEmpty();
+}
+
+/**
+ * @brief Forgets cached GET results and stops new callers from joining GETs that
+ * were issued before the state change (their results may predate it).
+ */
+void ProxmoxApiManager::invalidate_get_cache()
+{
+    fresh_gets.clear();
+    inflight_gets.clear();
 }
 
 /**
- * @brief Core login function. Returns tokens or an empty map on failure.
+ * @brief Core login function. The callback receives the tokens, or an empty map on failure.
  */
-std::map<std::string, std::string> ProxmoxApiManager::proxmox_login_core(
+void ProxmoxApiManager::proxmox_login_core(
     const std::string& password, const std::string& host, 
-    const std::string& username, const std::string& realm)
+    const std::string& username, const std::string& realm,
+    std::function<void(const std::map<std::string, std::string>&)> onDone)
 {
-    CURL *curl;
-    CURLcode res;
-    std::string readBuffer;
-    std::map<std::string, std::string> tokens;
-    
-    std::string ticket_url = "https://" + host + ":" + std::to_string(PROXMOX_PORT) + "/api2/json/access/ticket";
-    
     std::string username_realm = username + "@" + realm;
-    std::string post_data = "username=" + username_realm + "&password=" + password;
 
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, ticket_url.c_str()); 
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data.c_str());
-
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-        if (!VERIFY_SSL) {
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        }
+    ApiRequest request;
+    request.method = ApiRequest::Method::Post;
+    request.url = "https://" + host + ":" + std::to_string(PROXMOX_PORT) + "/api2/json/access/ticket";
+    request.postFields = "username=" + formEncode(username_realm) + "&password=" + formEncode(password);
+    request.verifySsl = VERIFY_SSL;
 
-        res = curl_easy_perform(curl);
-        
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        
-        curl_easy_cleanup(curl);
+    requestEngine->submit(request, this, [this, host, onDone](const ApiResponse& response) {
+        std::map<std::string, std::string> tokens;
+        endpoints->reportResult(QString::fromStdString(host), response);
 
-        if (res != CURLE_OK || http_code != 200) {
-            qCritical() << "Login Failed. CURL Error:" << curl_easy_strerror(res) << "(HTTP:" << http_code << ")";
-            return tokens;
+        if (!response.ok()) {
+            qCritical() << "Login Failed. CURL Error:" << curl_easy_strerror(response.curlCode) << "(HTTP:" << response.httpCode << ")";
+            onDone(tokens);
+            return;
         }
 
         try {
-            json response = json::parse(readBuffer);
-            json data = response["data"];
+            json parsed = json::parse(response.body);
+            json data = parsed["data"];
             
             std::string ticket = data.value("ticket", "");
             std::string csrf_token = data.value("CSRFPreventionToken", "");
@@ -198,39 +303,184 @@ std::map<std::string, std::string> ProxmoxApiManager::proxmox_login_core(
         } catch (const json::parse_error& e) {
             qCritical() << "JSON Parsing Error:" << e.what();
         }
-    }
-    return tokens;
+        onDone(tokens);
+    });
 }
 
 // --- PUBLIC SLOTS (Main entry points for the GUI) ---
 
 /**
- * @brief Handles the login process and emits signals.
+ * @brief Handles the login process and emits signals once the ticket request completes.
  */
 void ProxmoxApiManager::doLogin(const QString& host, const QString& username, const QString& realm, const QString& password)
 {
     // Clear previous state
-    auth_cookie_qt.clear();
-    csrf_token_qt.clear();
-    host_qt.clear();
+    {
+        QMutexLocker locker(&state_mutex);
+        auth_mode = AuthMode::Ticket;
+        auth_cookie_qt.clear();
+        csrf_token_qt.clear();
+        api_token_qt.clear();
+        host_qt.clear();
+    }
+    invalidate_get_cache();
+    
+    // Abandon renewal of the previous session
+    session_generation++;
+    tasks->clear();
+    rrd->clear();
+    inventory_saved.invalidate();
+    renewal_in_flight = false;
+    ticketRenewalTimer->stop();
+    login_username = username.toStdString();
+    login_realm = realm.toStdString();
+
+    // The host field may name several cluster nodes; any of them can issue the ticket
+    endpoints->setEndpoints(EndpointSelector::parseHostList(host));
+    attempt_login(QStringList(), host, username, realm, password);
+}
+
+/**
+ * @brief Requests a ticket from the best endpoint not tried yet. If that node is
+ * unreachable the next one is tried; a rejected password is reported right away
+ * (every node would reject it the same way).
+ */
+void ProxmoxApiManager::attempt_login(QStringList tried, const QString& host, const QString& username, const QString& realm, const QString& password)
+{
+    QString endpoint = endpoints->select(tried);
+    if (endpoint.isEmpty()) {
+        emit loginFailure("Login failed. No reachable host.");
+        return;
+    }
+    tried.append(endpoint);
+    quint64 generation = session_generation;
 
     // Core login (uses std::string)
-    std::map<std::string, std::string> tokens = proxmox_login_core(
+    proxmox_login_core(
         password.toStdString(), 
-        host.toStdString(), 
+        endpoint.toStdString(), 
         username.toStdString(), 
-        realm.toStdString());
-
-    if (!tokens.empty()) {
-        host_qt = host;
-        auth_cookie_qt = QString::fromStdString(tokens["PVEAuthCookie"]);
-        csrf_token_qt = QString::fromStdString(tokens["CSRFPreventionToken"]);
-        
-        qInfo() << "Login successful for" << username + "@" + realm + ".";
-        emit loginSuccess();
-    } else {
-        emit loginFailure("Login failed. Check host, username, password, and realm.");
+        realm.toStdString(),
+        [this, tried, endpoint, generation, host, username, realm, password](const std::map<std::string, std::string>& tokens) {
+            if (generation != session_generation) return; // Superseded by a newer login
+            
+            if (tokens.empty() && !endpoints->isHealthy(endpoint) && !endpoints->select(tried).isEmpty()) {
+                qInfo() << "Login: host" << endpoint << "unreachable, trying the next one.";
+                attempt_login(tried, host, username, realm, password);
+                return;
+            }
+            
+            if (!tokens.empty()) {
+                {
+                    QMutexLocker locker(&state_mutex);
+                    host_qt = host;
+                    auth_cookie_qt = QString::fromStdString(tokens.at("PVEAuthCookie"));
+                    csrf_token_qt = QString::fromStdString(tokens.at("CSRFPreventionToken"));
+                }
+                ticket_issued = QDateTime::currentDateTimeUtc();
+                scheduleTicketRenewal();
+                
+                qInfo() << "Login successful for" << username + "@" + realm + ".";
+                emit loginSuccess();
+            } else {
+                emit loginFailure("Login failed. Check host, username, password, and realm.");
+            }
+        });
+}
+
+/**
+ * @brief Switches to API token authentication. There is no login round trip:
+ * the token is sent with every request, so loginSuccess is emitted right away and
+ * a wrong token only shows up as failing requests. Tokens never need renewal.
+ * @param tokenId Full token ID, "user@realm!tokenname"
+ */
+void ProxmoxApiManager::useApiToken(const QString& host, const QString& tokenId, const QString& secret)
+{
+    if (host.trimmed().isEmpty() || !tokenId.contains('!') || secret.isEmpty()) {
+        emit loginFailure("API token login needs a host, a token ID of the form user@realm!name, and the secret.");
+        return;
+    }
+
+    session_generation++;
+    tasks->clear();
+    rrd->clear();
+    inventory_saved.invalidate();
+    renewal_in_flight = false;
+    ticketRenewalTimer->stop();
+    ticket_issued = QDateTime();
+    {
+        QMutexLocker locker(&state_mutex);
+        auth_mode = AuthMode::ApiToken;
+        host_qt = host.trimmed();
+        api_token_qt = tokenId.trimmed() + "=" + secret.trimmed();
+        auth_cookie_qt.clear();
+        csrf_token_qt.clear();
     }
+    invalidate_get_cache();
+    endpoints->setEndpoints(EndpointSelector::parseHostList(host));
+
+    qInfo() << "Using API token" << tokenId.trimmed() << "for" << host.trimmed();
+    emit loginSuccess();
+}
+
+/**
+ * @brief Arms the renewal timer for TICKET_RENEW_AFTER_SECS after the ticket was issued.
+ */
+void ProxmoxApiManager::scheduleTicketRenewal()
+{
+    qint64 age = ticket_issued.secsTo(QDateTime::currentDateTimeUtc());
+    qint64 delay = qMax<qint64>(0, TICKET_RENEW_AFTER_SECS - age);
+    ticketRenewalTimer->start(static_cast<int>(delay * 1000));
+}
+
+void ProxmoxApiManager::renewTicketIfDue()
+{
+    if (renewal_in_flight || !ticket_issued.isValid()) return;
+    if (ticket_issued.secsTo(QDateTime::currentDateTimeUtc()) >= TICKET_RENEW_AFTER_SECS) {
+        renewTicket();
+    }
+}
+
+/**
+ * @brief Exchanges the current ticket for a new one (POST /access/ticket with the
+ * ticket as password). Failures are retried every TICKET_RETRY_SECS until the old
+ * ticket expires.
+ */
+void ProxmoxApiManager::renewTicket()
+{
+    QString cookie = getAuthCookie();
+    if (renewal_in_flight || cookie.isEmpty()) return;
+    renewal_in_flight = true;
+    ticketRenewalTimer->stop();
+
+    std::string ticket = cookie.mid(QString("PVEAuthCookie=").size()).toStdString();
+    quint64 generation = session_generation;
+
+    proxmox_login_core(ticket, endpoints->select().toStdString(), login_username, login_realm,
+        [this, generation](const std::map<std::string, std::string>& tokens) {
+            if (generation != session_generation) return; // A new login replaced this session
+            renewal_in_flight = false;
+
+            if (!tokens.empty()) {
+                {
+                    QMutexLocker locker(&state_mutex);
+                    auth_cookie_qt = QString::fromStdString(tokens.at("PVEAuthCookie"));
+                    csrf_token_qt = QString::fromStdString(tokens.at("CSRFPreventionToken"));
+                }
+                ticket_issued = QDateTime::currentDateTimeUtc();
+                scheduleTicketRenewal();
+                qInfo() << "Renewed PVE ticket; next renewal in" << TICKET_RENEW_AFTER_SECS / 60 << "minutes.";
+                return;
+            }
+
+            qint64 age = ticket_issued.secsTo(QDateTime::currentDateTimeUtc());
+            if (age + TICKET_RETRY_SECS < TICKET_LIFETIME_SECS) {
+                qWarning() << "Ticket renewal failed; retrying in" << TICKET_RETRY_SECS << "seconds.";
+                ticketRenewalTimer->start(TICKET_RETRY_SECS * 1000);
+            } else {
+                qCritical() << "Ticket renewal failed and the ticket has expired. Please log in again.";
+            }
+        });
 }
 
 /**
@@ -238,14 +488,23 @@ void ProxmoxApiManager::doLogin(const QString& host, const QString& username, co
  */
 void ProxmoxApiManager::fetchVmList()
 {
-    if (auth_cookie_qt.isEmpty() || csrf_token_qt.isEmpty()) {
+    if (!isAuthenticated()) {
         qCritical() << "Authentication tokens are missing. Please log in first.";
         return;
     }
     
     QString path = "/cluster/resources?type=vm"; 
-    std::string json_response = proxmox_get(path.toStdString());
-    
+    proxmox_get(path.toStdString(), [this](const std::string& json_response) {
+        handleVmListResponse(json_response);
+    });
+}
+
+/**
+ * @brief Parses a /cluster/resources response into Vm records and emits vmListReady.
+ * The response is consumed with a SAX parser, so no JSON DOM is built for it.
+ */
+void ProxmoxApiManager::handleVmListResponse(const std::string& json_response)
+{
     QVector<Vm> vm_list;
 
     if (json_response.empty()) {
@@ -253,40 +512,45 @@ void ProxmoxApiManager::fetchVmList()
         return;
     }
 
-    try {
-        json response = json::parse(json_response);
-        for (const auto& item : response["data"]) {
-            std::string type_std = item.value("type", "");
-            
-            if (type_std == "qemu" || type_std == "lxc") {
-                Vm vm;
-                vm.vmid = item.value("vmid", 0);
-                vm.type = QString::fromStdString(type_std);
-                vm.status = QString::fromStdString(item.value("status", "N/A"));
-                vm.node = QString::fromStdString(item.value("node", "N/A"));
-                vm.name = QString::fromStdString(item.value("name", "N/A"));
-                
-                // Assign folder based on local map
-                auto folder_it = vm_folders_std.find(vm.vmid);
-                if (folder_it != vm_folders_std.end()) {
-                    vm.folder = QString::fromStdString(folder_it->second);
-                } else {
-                    vm.folder = "Unassigned";
-                }
+    QElapsedTimer parseTimer;
+    parseTimer.start();
 
-                vm_list.push_back(vm);
-            }
+    std::string parse_error;
+    if (!VmResourceSaxParser::parse(json_response, vm_list, &parse_error)) {
+        qCritical() << "JSON Parsing Error:" << QString::fromStdString(parse_error);
+        return;
+    }
+
+    // Assign folders based on local map
+    QMutexLocker locker(&state_mutex);
+    for (Vm& vm : vm_list) {
+        auto folder_it = vm_folders_std.find(vm.vmid);
+        if (folder_it != vm_folders_std.end()) {
+            vm.folder = QString::fromStdString(folder_it->second);
+        } else {
+            vm.folder = "Unassigned";
         }
-    } catch (const json::parse_error& e) {
-        qCritical() << "JSON Parsing Error:" << e.what();
     }
-    
+    locker.unlock();
+
+    // Once per poll: only with QT_LOGGING_RULES="proxmox.perf.debug=true"
+    qCDebug(lcPerf) << "Parsed" << vm_list.size() << "guests from" << json_response.size() << "bytes in" << parseTimer.nsecsElapsed() / 1000 << "us (SAX)";
+    qCDebug(lcPerf) << "Connection pool:" << QString::fromStdString(CurlConnectionPool::instance().statsSummary());
+    qCDebug(lcPerf) << "GET coalescing:" << gets_issued << "issued," << gets_coalesced << "joined in flight," << gets_served_fresh << "served fresh,"
+            << gets_retried << "retried on another node";
     emit vmListReady(vm_list);
+    
+    // Keep the startup cache current (written here, off the GUI thread), at most once a minute
+    if (!inventory_saved.isValid() || inventory_saved.elapsed() >= INVENTORY_SAVE_INTERVAL_MS) {
+        InventoryCache::save(QString::fromStdString(INVENTORY_CACHE_FILE), getHost(), vm_list);
+        inventory_saved.start();
+    }
 }
 
 
 /**
- * @brief Saves a folder assignment and updates the local persistence file.
+ * @brief Records a folder assignment. The change is queued to the folder store's
+ * journal; no file is rewritten here, so bulk reorganizations stay cheap.
  */
 void ProxmoxApiManager::setVmFolder(int vmid, const QString& folderName)
 {
@@ -298,70 +562,57 @@ void ProxmoxApiManager::setVmFolder(int vmid, const QString& folderName)
     std::string folderName_std = folderName.trimmed().toStdString();
     
     // Update the local map
-    vm_folders_std[vmid] = folderName_std;
-    
-    // Save to disk
-    save_vm_folders(vm_folders_std);
+    {
+        QMutexLocker locker(&state_mutex);
+        vm_folders_std[vmid] = folderName_std;
+    }
     
-    emit actionSuccess(QString("VMID %1 assigned to folder '%2'. Refresh list to see grouping.").arg(vmid).arg(folderName));
+    // Persist in the background (the model already shows the new grouping)
+    folderStore.assign(vmid, folderName_std);
 }
 
 // --- POST REQUEST / VM ACTION (Similar adaptation to proxmox_get) ---
 
 /**
  * @brief Performs a generic authenticated POST request to the Proxmox API.
- * NOTE: This is implemented here for simplicity, but ideally should be separate 
- * from proxmox_get or use a common helper function.
+ * The callback receives the response body, or an empty string on failure.
  */
-std::string proxmox_post_core(const std::string& path, const QString& auth_cookie_qt, const QString& csrf_token_qt, const QString& host_qt)
+void ProxmoxApiManager::proxmox_post_core(const std::string& path, std::function<void(const std::string&)> onDone)
 {
-    CURL *curl;
-    CURLcode res;
-    std::string readBuffer;
-    
-    std::string host_std = host_qt.toStdString();
-    std::string auth_cookie_std = auth_cookie_qt.toStdString();
-    std::string csrf_token_std = csrf_token_qt.toStdString();
+    renewTicketIfDue();
     
-    std::string url = "https://" + host_std + ":" + std::to_string(PROXMOX_PORT) + "/api2/json" + path;
+    // Not retried elsewhere: a POST may have taken effect even if the answer was lost
+    QString endpoint = endpoints->select();
     
-    curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POST, 1L); 
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, ""); // Empty POST for status actions
-
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-        if (!VERIFY_SSL) {
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    ApiRequest request;
+    request.method = ApiRequest::Method::Post;
+    request.postFields = ""; // Empty POST for status actions
+    prepare_request(path, request, endpoint);
+
+    // Anything read before this POST may no longer reflect cluster state
+    invalidate_get_cache();
+
+    requestEngine->submit(request, this, [this, path, endpoint, onDone](const ApiResponse& response) {
+        endpoints->reportResult(endpoint, response);
+        invalidate_get_cache();
+        if (!response.ok()) {
+            qWarning() << "CURL Error (POST" << QString::fromStdString(path) << "):" << curl_easy_strerror(response.curlCode) << "(HTTP:" << response.httpCode << ")";
+            onDone("");
+            return;
         }
+        onDone(response.body);
+    });
+}
 
-        struct curl_slist *headers = NULL;
-        std::string cookie_header = "Cookie: " + auth_cookie_std;
-        std::string csrf_header = "CSRFPreventionToken: " + csrf_token_std;
-        
-        headers = curl_slist_append(headers, cookie_header.c_str());
-        headers = curl_slist_append(headers, csrf_header.c_str());
-        headers = curl_slist_append(headers, "Accept: application/json");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-        res = curl_easy_perform(curl);
-        
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-        
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-
-        if (res != CURLE_OK || http_code != 200) {
-            qWarning() << "CURL Error (POST" << QString::fromStdString(path) << "):" << curl_easy_strerror(res) << "(HTTP:" << http_code << ")";
-            return ""; 
-        }
-    }
-    return readBuffer;
+void ProxmoxApiManager::publishRequestMetrics()
+{
+    emit requestMetricsReady(QString::fromStdString(requestEngine->metrics().toJson()));
+}
+
+void ProxmoxApiManager::fetchRrdData(int vmid, const QString& node, const QString& type, const QString& timeframe, bool prefetch)
+{
+    if (!isAuthenticated()) return;
+    rrd->request(vmid, node, type, timeframe, !prefetch);
 }
 
 /**
@@ -374,36 +625,203 @@ std::string proxmox_post_core(const std::string& path, const QString& auth_cooki
 void ProxmoxApiManager::performVmAction(const QString& action, int vmid, const Vm& vm_data)
 {
     if (vm_data.vmid == 0 || vm_data.node.isEmpty()) {
-        emit actionSuccess(QString("Error: VMID %1 not found or data is incomplete.").arg(vmid));
+        emit vmActionFailed(vmid, action, QString("VMID %1 not found or data is incomplete.").arg(vmid));
         return;
     }
     
-    QString vm_type_path = (vm_data.type.toLower() == "qemu") ? "qemu" : "lxc";
-    
-    QString api_path = QString("/nodes/%1/%2/%3/status/%4")
-                            .arg(vm_data.node)
-                            .arg(vm_type_path)
-                            .arg(vmid)
-                            .arg(action);
+    QString api_path = action_path(action, vm_data);
 
     qInfo() << "Attempting to send '" << action << "' command for VMID" << vmid << "(" << vm_data.name << ")...";
     
-    std::string json_response = proxmox_post_core(api_path.toStdString(), auth_cookie_qt, csrf_token_qt, host_qt);
+    proxmox_post_core(api_path.toStdString(), [this, action, vm_data](const std::string& json_response) {
+        if (json_response.empty()) {
+            emit vmActionFailed(vm_data.vmid, action, "Action failed or returned an error.");
+            return;
+        }
 
-    if (json_response.empty()) {
-        emit actionSuccess("Action failed or returned an error.");
-        return;
+        json response = json::parse(json_response, nullptr, false);
+        if (response.is_discarded()) {
+            qCritical() << "JSON Parsing Error in action response for VMID" << vm_data.vmid;
+            emit vmActionFailed(vm_data.vmid, action, "Unreadable response from the server.");
+            return;
+        }
+        // A refused action answers {"data": null}; only a UPID string means a task was started
+        if (!response.contains("data") || !response["data"].is_string()) {
+            emit vmActionFailed(vm_data.vmid, action, "Response structure unexpected. Check server logs.");
+            return;
+        }
+
+        QString taskId = QString::fromStdString(response["data"].get<std::string>());
+        tasks->track(taskId, vm_data, action);
+        emit actionSuccess(QString("Task started: %1. The VM row updates when it finishes.").arg(taskId));
+    });
+}
+
+QString ProxmoxApiManager::action_path(const QString& action, const Vm& vm)
+{
+    QString vm_type_path = (vm.type.toLower() == "qemu") ? "qemu" : "lxc";
+    return QString("/nodes/%1/%2/%3/status/%4")
+               .arg(vm.node)
+               .arg(vm_type_path)
+               .arg(vm.vmid)
+               .arg(action);
+}
+
+// --- BULK VM ACTIONS ---
+
+/**
+ * @brief Fans a power action out over many VMs. Each node gets its own queue and at
+ * most MAX_ACTIONS_PER_NODE POSTs in flight, so one busy node cannot hold up the
+ * others and no node's pveproxy is flooded. Only aggregated progress is emitted.
+ */
+void ProxmoxApiManager::performBulkVmAction(quint64 jobId, const QString& action, const QVector<Vm>& vms)
+{
+    auto job = std::make_shared<BulkJob>();
+    job->id = jobId;
+    job->action = action;
+    job->elapsed.start();
+
+    for (const Vm& vm : vms) {
+        if (vm.vmid == 0 || vm.node.isEmpty()) {
+            job->failed++;
+            job->errors.append(QString("VMID %1: data is incomplete").arg(vm.vmid));
+            continue;
+        }
+        job->queued[vm.node].push_back(vm);
     }
+    job->total = vms.size();
+    bulk_jobs[jobId] = job;
 
-    try {
-        json response = json::parse(json_response);
-        if (response.count("data")) {
-            QString taskId = QString::fromStdString(response["data"].get<std::string>());
-            emit actionSuccess(QString("Success! Task ID: %1. Check the Proxmox UI.").arg(taskId));
-        } else {
-            emit actionSuccess("Action completed but response structure unexpected. Check server logs.");
+    qInfo() << "Bulk" << action << "of" << vms.size() << "guests on" << job->queued.size() << "nodes started.";
+    emit bulkActionProgress(jobId, job->failed, job->failed, job->total);
+
+    for (const auto& queue : job->queued) {
+        pump_bulk_job(job, queue.first);
+    }
+    finish_bulk_job_if_done(job);
+}
+
+void ProxmoxApiManager::pump_bulk_job(const std::shared_ptr<BulkJob>& job, const QString& node)
+{
+    std::deque<Vm>& queue = job->queued[node];
+    int& inFlight = job->inFlight[node];
+
+    while (inFlight < MAX_ACTIONS_PER_NODE && !queue.empty()) {
+        Vm vm = queue.front();
+        queue.pop_front();
+        inFlight++;
+
+        proxmox_post_core(action_path(job->action, vm).toStdString(), [this, job, node, vm](const std::string& json_response) {
+            job->inFlight[node]--;
+
+            QString error;
+            if (json_response.empty()) {
+                error = "request failed";
+            } else {
+                json response = json::parse(json_response, nullptr, false);
+                if (response.is_discarded() || !response.contains("data") || !response["data"].is_string()) {
+                    error = "unexpected response";
+                } else {
+                    tasks->track(QString::fromStdString(response["data"].get<std::string>()), vm, job->action);
+                }
+            }
+
+            if (error.isEmpty()) {
+                job->succeeded++;
+            } else {
+                job->failed++;
+                job->errors.append(QString("VMID %1 (%2 on %3): %4").arg(vm.vmid).arg(vm.name).arg(node).arg(error));
+                emit vmActionFailed(vm.vmid, job->action, error);
+            }
+            emit bulkActionProgress(job->id, job->succeeded + job->failed, job->failed, job->total);
+
+            pump_bulk_job(job, node);
+            finish_bulk_job_if_done(job);
+        });
+    }
+}
+
+void ProxmoxApiManager::finish_bulk_job_if_done(const std::shared_ptr<BulkJob>& job)
+{
+    for (const auto& queue : job->queued) {
+        if (!queue.second.empty()) return;
+    }
+    for (const auto& running : job->inFlight) {
+        if (running.second > 0) return;
+    }
+    if (bulk_jobs.erase(job->id) == 0) return; // Already reported
+
+    qInfo() << "Bulk" << job->action << "finished in" << job->elapsed.elapsed() << "ms:" << job->succeeded << "ok,"
+            << job->failed << "failed," << job->skipped << "skipped.";
+    emit bulkActionFinished(job->id, job->succeeded, job->failed, job->skipped, job->errors);
+}
+
+void ProxmoxApiManager::cancelBulkVmAction(quint64 jobId)
+{
+    auto it = bulk_jobs.find(jobId);
+    if (it == bulk_jobs.end()) return;
+
+    std::shared_ptr<BulkJob> job = it->second;
+    for (auto& queue : job->queued) {
+        job->skipped += static_cast<int>(queue.second.size());
+        for (const Vm& vm : queue.second) {
+            emit vmActionFailed(vm.vmid, job->action, "cancelled");
         }
-    } catch (const json::parse_error& e) {
-        qCritical() << "JSON Parsing Error in action response:" << e.what();
+        queue.second.clear();
+    }
+    finish_bulk_job_if_done(job);
+}
+
+// --- TASK COMPLETION ---
+
+void ProxmoxApiManager::handleTaskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus)
+{
+    emit taskFinished(upid, vm, action, ok, exitStatus);
+
+    // Tasks of one poll round finish together; re-read their VMs once, after the round
+    if (vms_to_refresh.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this]() { refreshFinishedVms(); }, Qt::QueuedConnection);
     }
-}
\ No newline at end of file
+    vms_to_refresh.append(vm);
+}
+
+/**
+ * @brief Reads the current state of the VMs whose tasks just ended and emits
+ * vmStatusChanged for each. One /nodes/{node}/{qemu|lxc} listing per node and guest
+ * type: those are answered by the node itself, whereas /cluster/resources comes from
+ * pvestatd's status cache and can still show the state from before the task.
+ */
+void ProxmoxApiManager::refreshFinishedVms()
+{
+    QVector<Vm> finished;
+    finished.swap(vms_to_refresh);
+    if (finished.isEmpty()) return;
+
+    std::map<QString, std::set<int>> wanted;   // listing path -> vmids to report
+    for (const Vm& vm : finished) {
+        QString vm_type_path = (vm.type.toLower() == "qemu") ? "qemu" : "lxc";
+        wanted[QString("/nodes/%1/%2").arg(vm.node).arg(vm_type_path)].insert(vm.vmid);
+    }
+
+    for (const auto& listing : wanted) {
+        const std::set<int> vmids = listing.second;
+        // A listing already in flight was issued before the tasks ended; don't attach to it
+        proxmox_get(listing.first.toStdString(), [this, vmids](const std::string& json_response) {
+            json response = json::parse(json_response, nullptr, false);
+            if (json_response.empty() || response.is_discarded() || !response.contains("data") || !response["data"].is_array()) {
+                qWarning() << "Could not read the status of" << vmids.size() << "VM(s) after their tasks ended.";
+                return;
+            }
+            for (const json& entry : response["data"]) {
+                if (!entry.is_object() || !entry.contains("vmid")) continue;
+                // qemu lists the vmid as a number, lxc as a string
+                const json& id = entry["vmid"];
+                int vmid = id.is_number_integer() ? id.get<int>()
+                         : id.is_string() ? QString::fromStdString(id.get<std::string>()).toInt() : 0;
+                if (!vmids.count(vmid)) continue;
+                emit vmStatusChanged(vmid, QString::fromStdString(entry.value("status", std::string())),
+                                     QString::fromStdString(entry.value("name", std::string())));
+            }
+        }, false, false);
+    }
+}
@@ -2,15 +2,27 @@
 #define PROXMOXAPIMANAGER_H
 
 #include <QObject>
+#include <QDateTime>
 #include <QMap>
+#include <QMutex>
 #include <QString>
+#include <QTimer>
 #include <QVector>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include "json.hpp" // Ensure nlohmann/json is accessible
+#include "ApiRequestEngine.h"
+#include "FolderStore.h"
+#include "EndpointSelector.h"
+#include "RrdFetcher.h"
 
 using json = nlohmann::json;
 
+class TaskTracker;
+
 // --- DATA STRUCTURES (Using Qt types where possible for GUI compatibility) ---
 struct Vm
 {
@@ -20,6 +32,21 @@ struct Vm
     QString node;
     QString name;
     QString folder = "Unassigned"; 
+    QString pool;                   // Resource pool; empty if the guest is in none
+    double cpu = 0.0;               // CPU usage as a fraction (0..1) of the guest's vCPUs
+    int maxcpu = 0;                 // vCPUs configured
+    qint64 mem = 0;                 // Bytes in use
+    qint64 maxmem = 0;              // Bytes configured
+    qint64 disk = 0;                // Root disk bytes in use (PVE reports 0 for most qemu guests)
+    qint64 maxdisk = 0;             // Root disk size
+    qint64 netin = 0;               // Byte counters since the guest started
+    qint64 netout = 0;
+    qint64 diskread = 0;
+    qint64 diskwrite = 0;
+    qint64 uptime = 0;              // Seconds; 0 when not running
+    QString tags;                   // ';'-separated, as PVE sends them
+    QString hastate;                // HA state ("started", "stopped", ...); empty if not HA-managed
+    bool isTemplate = false;
 };
 
 // Required for Q_DECLARE_METATYPE so Vm can be used in Signals/Slots
@@ -31,24 +58,58 @@ class ProxmoxApiManager : public QObject
 
 public:
     explicit ProxmoxApiManager(QObject *parent = nullptr);
+    ~ProxmoxApiManager() override;
+
+    enum class AuthMode { Ticket, ApiToken };
 
-    // --- Public accessors for tokens ---
-    QString getAuthCookie() const { return auth_cookie_qt; }
-    QString getCsrfToken() const { return csrf_token_qt; }
-    QString getHost() const { return host_qt; }
+    // --- Public accessors for tokens (safe from any thread) ---
+    QString getAuthCookie() const { QMutexLocker locker(&state_mutex); return auth_cookie_qt; }
+    QString getCsrfToken() const { QMutexLocker locker(&state_mutex); return csrf_token_qt; }
+    QString getHost() const { QMutexLocker locker(&state_mutex); return host_qt; }
+    QString getVmFolder(int vmid) const;
+    AuthMode getAuthMode() const { QMutexLocker locker(&state_mutex); return auth_mode; }
+    bool isAuthenticated() const;
+
+    // --- GET coalescing ---
+    // Identical GETs issued within this window reuse the last response (0 disables reuse;
+    // concurrent identical GETs are always merged into one request).
+    void setGetFreshnessWindow(int msecs) { get_freshness_ms = msecs; }
+    int getFreshnessWindow() const { return get_freshness_ms; }
 
 public slots:
-    // Initiates login (will run on a background thread if implemented correctly)
+    // Loads local data and emits cachedVmListReady if an inventory cache exists
+    // (folderStoreWarning first if the folder file could not be read).
+    // Runs on the manager's own thread once it starts (see ProxmoxClientWindow).
+    void initialize();
+
+    // Initiates login. Returns immediately; the result arrives via loginSuccess/loginFailure.
     void doLogin(const QString& host, const QString& username, const QString& realm, const QString& password);
     
-    // Initiates VM list fetch
+    // Authenticates every request with a PVE API token instead of a ticket (no login
+    // round trip, no CSRF token, no renewal). Emits loginSuccess/loginFailure immediately.
+    void useApiToken(const QString& host, const QString& tokenId, const QString& secret);
+    
+    // Initiates VM list fetch (asynchronous, emits vmListReady)
     void fetchVmList();
     
-    // Saves a folder assignment
+    // Records a folder assignment (persisted in the background, see FolderStore)
     void setVmFolder(int vmid, const QString& folderName);
 
     // FIX: ADDED MISSING DECLARATION FOR THE VM ACTION METHOD (Declared as slot for signal connection)
     void performVmAction(const QString& action, int vmid, const Vm& vm_data);
+    
+    // Runs 'action' on every VM in 'vms', with at most a few POSTs in flight per node.
+    // Reports through bulkActionProgress/bulkActionFinished only (no per-VM actionSuccess).
+    void performBulkVmAction(quint64 jobId, const QString& action, const QVector<Vm>& vms);
+    // Drops the part of a bulk job not sent yet; POSTs already sent complete normally.
+    void cancelBulkVmAction(quint64 jobId);
+    
+    // Emits requestMetricsReady with the current timing histograms (RequestMetrics JSON)
+    void publishRequestMetrics();
+    
+    // RRD statistics of one guest ('timeframe': hour, day, week, month or year), answered
+    // through rrdDataReady, from cache when fresh. A prefetch only warms the cache.
+    void fetchRrdData(int vmid, const QString& node, const QString& type, const QString& timeframe, bool prefetch);
 
 signals:
     // Emitted on login success/failure
@@ -58,25 +119,138 @@ signals:
     // Emitted when the VM list is ready
     void vmListReady(const QVector<Vm>& vms);
     
+    // Emitted at startup with the last inventory fetched from 'host' (may be outdated)
+    void cachedVmListReady(const QVector<Vm>& vms, const QString& host, const QDateTime& savedAt);
+    // The stored folder assignments could not be read at startup (see FolderStore::loadWarning)
+    void folderStoreWarning(const QString& message);
+    
+    // Health/RTT of every configured cluster endpoint and the one requests currently go to
+    void endpointStatusChanged(const QVector<EndpointStatus>& endpoints, const QString& selected, const QString& reason);
+    
+    // A task started by a power action ended ('exitStatus' is "OK" or the error text)
+    void taskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus);
+    // Live status and name of a VM whose task just ended (only those fields are patched)
+    void vmStatusChanged(int vmid, const QString& status, const QString& name);
+    
+    // Bulk power actions: 'completed' counts finished POSTs, successful or not
+    void bulkActionProgress(quint64 jobId, int completed, int failed, int total);
+    void bulkActionFinished(quint64 jobId, int succeeded, int failed, int skipped, const QStringList& errors);
+    
+    // Per-endpoint request timing histograms, see RequestMetrics::toJson()
+    void requestMetricsReady(const QString& json);
+    
+    // Answer to fetchRrdData ('error' empty on success); see RrdFetcher::ready
+    void rrdDataReady(int vmid, const QString& timeframe, const RrdSeries& series, const QString& error);
+    
     // Emitted when an action is successful
     void actionSuccess(const QString& message);
+    // A power action could not be started (single or bulk); the VM's state is unchanged
+    void vmActionFailed(int vmid, const QString& action, const QString& reason);
     
 private:
     // --- Member variables for state ---
-    QString host_qt;
+    // The manager lives on a worker thread; the tokens and the folder map may also be
+    // read through the accessors above, so every access goes through state_mutex.
+    mutable QMutex state_mutex;
+    AuthMode auth_mode = AuthMode::Ticket;
+    QString host_qt;        // As entered: one host or a list of cluster nodes (see EndpointSelector)
     QString auth_cookie_qt;
     QString csrf_token_qt;
+    QString api_token_qt;   // "user@realm!tokenname=secret" (API token mode only)
     
     // Local persistence map (int VMID -> QString Folder)
     std::map<int, std::string> vm_folders_std; 
     
+    // Journaled on-disk copy of vm_folders_std
+    FolderStore folderStore;
+    
+    // Network thread running all curl transfers (owned, child QObject)
+    ApiRequestEngine *requestEngine = nullptr;
+    
+    // Picks the cluster node for each request (owned, child QObject)
+    EndpointSelector *endpoints = nullptr;
+    
+    // Follows the UPIDs returned by power actions (owned, child QObject)
+    TaskTracker *tasks = nullptr;
+    QVector<Vm> vms_to_refresh;             // VMs whose tasks ended; re-read in one batch
+    void handleTaskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus);
+    void refreshFinishedVms();
+    
+    // Per-guest RRD statistics with a per-timeframe cache (owned, child QObject)
+    RrdFetcher *rrd = nullptr;
+    
+    // --- Single-flight GET state (path -> callers waiting on the request in flight) ---
+    using GetCallback = std::function<void(const std::string&)>;
+    using GetWaiters = std::shared_ptr<std::vector<GetCallback>>;
+    struct CachedGet
+    {
+        QElapsedTimer age;
+        std::string body;
+    };
+    std::map<std::string, GetWaiters> inflight_gets;
+    std::map<std::string, CachedGet> fresh_gets;
+    int get_freshness_ms = 2000;
+    quint64 gets_issued = 0;
+    quint64 gets_coalesced = 0;
+    quint64 gets_served_fresh = 0;
+    quint64 gets_retried = 0;
+    
+    // Drops cached GET results and detaches in-flight GETs from new callers (after a state change)
+    void invalidate_get_cache();
+    
+    // Sets URL (on 'endpoint'), TLS and auth headers for 'path' according to the current AuthMode
+    void prepare_request(const std::string& path, ApiRequest& request, const QString& endpoint) const;
+    // 'keepFresh': store a successful body in fresh_gets
+    void submit_get(const std::string& path, GetWaiters waiters, QStringList tried, bool keepFresh);
+    void prune_fresh_gets();
+    void attempt_login(QStringList tried, const QString& host, const QString& username, const QString& realm, const QString& password);
+    
+    // --- Ticket renewal (PVE tickets expire two hours after they are issued) ---
+    // The current ticket is exchanged for a fresh one well before expiry. Requests
+    // keep using the old ticket until the new one arrives; it stays valid meanwhile.
+    QTimer *ticketRenewalTimer = nullptr;   // Single-shot, child of this object
+    QDateTime ticket_issued;                // UTC time the current ticket was obtained
+    std::string login_username;
+    std::string login_realm;
+    quint64 session_generation = 0;         // Bumped by doLogin; renewals of an older session are dropped
+    bool renewal_in_flight = false;
+    void scheduleTicketRenewal();
+    void renewTicket();
+    void renewTicketIfDue();                // Catches up when the timer fired late (e.g. after suspend)
+    
     // --- Adapted versions of your existing functions (private implementation) ---
-    std::map<std::string, std::string> proxmox_login_core(const std::string& password, const std::string& host, const std::string& username, const std::string& realm);
-    std::string proxmox_get(const std::string& path) const;
+    // All of these are asynchronous: the callback runs on this object's thread when the request completes.
+    void proxmox_login_core(const std::string& password, const std::string& host, const std::string& username, const std::string& realm,
+                            std::function<void(const std::map<std::string, std::string>&)> onDone);
+    // 'allowFresh' = false skips the freshness window both ways: no cached answer is used and
+    // none is kept (for polling and one-off paths: a reused answer is useless).
+    // 'joinInFlight' = false always sends a new request instead of attaching to an older one
+    void proxmox_get(const std::string& path, std::function<void(const std::string&)> onDone, bool allowFresh = true, bool joinInFlight = true);
+    void proxmox_post_core(const std::string& path, std::function<void(const std::string&)> onDone);
+    
+    void handleVmListResponse(const std::string& json_response);
+    QElapsedTimer inventory_saved;          // Last InventoryCache::save; invalid until the first one of a session
+    
+    // --- Bulk actions: one queue per node, drained with a per-node concurrency cap ---
+    struct BulkJob
+    {
+        quint64 id = 0;
+        QString action;
+        std::map<QString, std::deque<Vm>> queued;   // node -> VMs not sent yet
+        std::map<QString, int> inFlight;            // node -> POSTs outstanding
+        int total = 0;
+        int succeeded = 0;
+        int failed = 0;
+        int skipped = 0;                            // Cancelled before being sent
+        QStringList errors;
+        QElapsedTimer elapsed;
+    };
+    std::map<quint64, std::shared_ptr<BulkJob>> bulk_jobs;
+    void pump_bulk_job(const std::shared_ptr<BulkJob>& job, const QString& node);
+    void finish_bulk_job_if_done(const std::shared_ptr<BulkJob>& job);
     
-    // Local persistence (your original code)
-    std::map<int, std::string> load_vm_folders();
-    void save_vm_folders(const std::map<int, std::string>& folders);
+    // "/nodes/{node}/{qemu|lxc}/{vmid}/status/{action}"
+    static QString action_path(const QString& action, const Vm& vm);
 };
 
 #endif // PROXMOXAPIMANAGER_H
\ No newline at end of file
@@ -1,17 +1,58 @@
 # Project file (ProxmoxClient.pro)
 
 QT += widgets network
+CONFIG += c++17
+
+# Hot-path tracing (VmModel::data/rowCount, request events) is compiled out of
+# release builds. Build with "qmake CONFIG+=trace" to keep it in a release build.
+trace: DEFINES += PROXMOX_TRACE
 
 SOURCES += \
     main.cpp \
     ProxmoxApiManager.cpp \
+    CurlConnectionPool.cpp \
+    ApiRequestEngine.cpp \
+    VmResourceSaxParser.cpp \
     ProxmoxClientWindow.cpp \
-    VmModel.cpp # Removed proxmox_listvms.cpp
+    VmModel.cpp \
+    TreeItemPool.cpp \
+    Tracing.cpp \
+    StallMonitor.cpp \
+    FolderStore.cpp \
+    InventoryCache.cpp \
+    EndpointSelector.cpp \
+    DiagnosticsPanel.cpp \
+    RequestMetrics.cpp \
+    TaskTracker.cpp \
+    VmRecord.cpp \
+    VmInventory.cpp \
+    MetricsHistory.cpp \
+    RrdFetcher.cpp \
+    MetricChart.cpp \
+    VmDetailsPane.cpp # Removed proxmox_listvms.cpp
 
 HEADERS += \
     ProxmoxApiManager.h \
+    CurlConnectionPool.h \
+    ApiRequestEngine.h \
+    VmResourceSaxParser.h \
     ProxmoxClientWindow.h \
     VmModel.h \
+    TreeItemPool.h \
+    Tracing.h \
+    StallMonitor.h \
+    FolderStore.h \
+    InventoryCache.h \
+    EndpointSelector.h \
+    DiagnosticsPanel.h \
+    RequestMetrics.h \
+    TaskTracker.h \
+    VmRecord.h \
+    VmInventory.h \
+    MetricsHistory.h \
+    RrdFetcher.h \
+    MetricChart.h \
+    VmDetailsPane.h \
     json.hpp
 
 # Add the libcurl linker flag here:
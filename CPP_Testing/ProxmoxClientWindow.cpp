@@ -11,6 +11,14 @@
 #include <QTimer> 
 #include <QMenu>       // For context menu
 #include <QInputDialog> // For folder creation prompt
+#include <QSet>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHeaderView>
+#include "Tracing.h"
+
+// --- CONSTANTS ---
+const int VM_LIST_POLL_INTERVAL_MS = 5000;   // Live metrics: one /cluster/resources GET per interval
 
 
 ProxmoxClientWindow::ProxmoxClientWindow(QWidget *parent)
@@ -20,14 +28,80 @@ ProxmoxClientWindow::ProxmoxClientWindow(QWidget *parent)
     resize(500, 350); 
 
     // Initialize core components
-    apiManager = new ProxmoxApiManager(this);
     vmModel = new VmModel(this);
     
-    // Connect Signals from the API Manager
-    connect(apiManager, &ProxmoxApiManager::loginSuccess, this, &ProxmoxClientWindow::handleLoginSuccess);
-    connect(apiManager, &ProxmoxApiManager::loginFailure, this, &ProxmoxClientWindow::handleLoginFailure);
-    connect(apiManager, &ProxmoxApiManager::vmListReady, this, &ProxmoxClientWindow::handleVmListReady);
-    connect(apiManager, &ProxmoxApiManager::actionSuccess, this, &ProxmoxClientWindow::handleActionSuccess);
+    // Developer option: PROXMOX_STALL_MONITOR=1 probes the event loop every 20 ms and logs
+    // GUI stalls (with proxmox.perf debug output, and at exit)
+    if (qEnvironmentVariableIntValue("PROXMOX_STALL_MONITOR") > 0) {
+        stallMonitor = new StallMonitor(this);
+    }
+    
+    // Keeps the tree's status and usage columns live once logged in (see handleLoginSuccess)
+    vmListPollTimer = new QTimer(this);
+    vmListPollTimer->setInterval(VM_LIST_POLL_INTERVAL_MS);
+    connect(vmListPollTimer, &QTimer::timeout, this, &ProxmoxClientWindow::vmListRequested);
+    
+    // Network diagnostics, docked on the right and hidden until requested
+    diagnosticsPanel = new DiagnosticsPanel;
+    diagnosticsDock = new QDockWidget("Diagnostics", this);
+    diagnosticsDock->setObjectName("diagnosticsDock");
+    diagnosticsDock->setWidget(diagnosticsPanel);
+    addDockWidget(Qt::RightDockWidgetArea, diagnosticsDock);
+    diagnosticsDock->hide();
+    
+    // The API manager runs on its own thread so that response parsing, folder file
+    // I/O and request bookkeeping never block painting. It has no parent (a QObject
+    // cannot be moved with one) and is deleted on its thread when the thread finishes.
+    managerThread = new QThread(this);
+    managerThread->setObjectName("ProxmoxApiManager");
+    apiManager = new ProxmoxApiManager;
+    apiManager->moveToThread(managerThread);
+    connect(managerThread, &QThread::started, apiManager, &ProxmoxApiManager::initialize);
+    connect(managerThread, &QThread::finished, apiManager, &QObject::deleteLater);
+    
+    // Window -> manager (queued: runs on the manager thread)
+    connect(this, &ProxmoxClientWindow::loginRequested, apiManager, &ProxmoxApiManager::doLogin, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::apiTokenLoginRequested, apiManager, &ProxmoxApiManager::useApiToken, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::vmListRequested, apiManager, &ProxmoxApiManager::fetchVmList, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::vmActionRequested, apiManager, &ProxmoxApiManager::performVmAction, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::vmFolderAssignmentRequested, apiManager, &ProxmoxApiManager::setVmFolder, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::bulkVmActionRequested, apiManager, &ProxmoxApiManager::performBulkVmAction, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::bulkVmActionCancelRequested, apiManager, &ProxmoxApiManager::cancelBulkVmAction, Qt::QueuedConnection);
+    connect(this, &ProxmoxClientWindow::rrdDataRequested, apiManager, &ProxmoxApiManager::fetchRrdData, Qt::QueuedConnection);
+    
+    // Manager -> window (queued: runs on the GUI thread)
+    connect(apiManager, &ProxmoxApiManager::loginSuccess, this, &ProxmoxClientWindow::handleLoginSuccess, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::loginFailure, this, &ProxmoxClientWindow::handleLoginFailure, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::vmListReady, this, &ProxmoxClientWindow::handleVmListReady, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::cachedVmListReady, this, &ProxmoxClientWindow::handleCachedVmListReady, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::folderStoreWarning, this, &ProxmoxClientWindow::handleFolderStoreWarning, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::endpointStatusChanged, diagnosticsPanel, &DiagnosticsPanel::setEndpointStatus, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::requestMetricsReady, diagnosticsPanel, &DiagnosticsPanel::setRequestMetrics, Qt::QueuedConnection);
+    connect(diagnosticsPanel, &DiagnosticsPanel::metricsRequested, apiManager, &ProxmoxApiManager::publishRequestMetrics, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::actionSuccess, this, &ProxmoxClientWindow::handleActionSuccess, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::vmActionFailed, this, &ProxmoxClientWindow::handleVmActionFailed, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::bulkActionProgress, this, &ProxmoxClientWindow::handleBulkActionProgress, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::bulkActionFinished, this, &ProxmoxClientWindow::handleBulkActionFinished, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::taskFinished, this, &ProxmoxClientWindow::handleTaskFinished, Qt::QueuedConnection);
+    connect(apiManager, &ProxmoxApiManager::vmStatusChanged, vmModel, &VmModel::updateVmStatus, Qt::QueuedConnection);
+    
+    // Stop the manager (and with it the network thread) before main() shuts down libcurl
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        if (stallMonitor) qInfo().noquote() << stallMonitor->summary();
+        stopManagerThread();
+    });
+    
+    managerThread->start();
+    
+    // Headless / scripted starts: PROXMOX_HOST plus PROXMOX_API_TOKEN ("user@realm!name=secret")
+    // skip the login form entirely
+    const QString envHost = qEnvironmentVariable("PROXMOX_HOST");
+    const QString envToken = qEnvironmentVariable("PROXMOX_API_TOKEN");
+    int secretStart = envToken.indexOf('=');
+    if (!envHost.isEmpty() && secretStart > 0) {
+        loginHost = envHost;
+        emit apiTokenLoginRequested(envHost, envToken.left(secretStart), envToken.mid(secretStart + 1));
+    }
     
     // Initial UI setup (show login form first)
     setupLoginUI();
@@ -36,7 +110,16 @@ ProxmoxClientWindow::ProxmoxClientWindow(QWidget *parent)
 
 ProxmoxClientWindow::~ProxmoxClientWindow()
 {
-    // Components are deleted by the parent QObject (this) or qDeleteAll in VmModel
+    // Components are deleted by the parent QObject (this) or qDeleteAll in VmModel;
+    // the API manager is deleted on its own thread as that thread finishes
+    stopManagerThread();
+}
+
+void ProxmoxClientWindow::stopManagerThread()
+{
+    if (!managerThread || managerThread->isFinished()) return;
+    managerThread->quit();
+    managerThread->wait();
 }
 
 void ProxmoxClientWindow::setupLoginUI()
@@ -46,6 +129,7 @@ void ProxmoxClientWindow::setupLoginUI()
     
     // Create member variables (declared in header) to avoid Seg Fault
     hostEdit = new QLineEdit("https://your.proxmox.host:8006");
+    hostEdit->setToolTip("One host, or several nodes of the same cluster separated by commas (requests go to the fastest healthy one)");
     userEdit = new QLineEdit("root");
     passEdit = new QLineEdit;
     passEdit->setEchoMode(QLineEdit::Password);
@@ -56,6 +140,13 @@ void ProxmoxClientWindow::setupLoginUI()
     realmCombo->addItem("pve");
     realmCombo->addItem("ldap"); // Example realms
     
+    // API tokens: the username field takes the token ID, the password field the secret
+    apiTokenCheck = new QCheckBox("Use API token");
+    connect(apiTokenCheck, &QCheckBox::toggled, this, [this](bool useToken) {
+        userEdit->setPlaceholderText(useToken ? "user@realm!tokenname" : QString());
+        passEdit->setPlaceholderText(useToken ? "token secret" : QString());
+    });
+    
     loginButton = new QPushButton("LOGIN");
     connect(loginButton, &QPushButton::clicked, this, &ProxmoxClientWindow::on_loginButton_clicked);
     
@@ -84,7 +175,8 @@ void ProxmoxClientWindow::setupLoginUI()
     layout->addWidget(realmCombo, row, 1);
     row++;
 
-    // Row 4: Empty spacer for alignment
+    // Row 4: Auth mode
+    layout->addWidget(apiTokenCheck, row, 1);
     row++;
     
     // Row 5: Login button (right-aligned using QHBoxLayout in a wrapper or span column 1)
@@ -107,6 +199,15 @@ void ProxmoxClientWindow::setupMainUI()
     QWidget *leftPanel = new QWidget();
     vmTreeView = new QTreeView(leftPanel);
     vmTreeView->setModel(vmModel);
+    vmTreeView->expandAll(); // The model may already hold the cached inventory
+    vmTreeView->setSelectionMode(QAbstractItemView::ExtendedSelection); // Ctrl/Shift for bulk actions
+    vmTreeView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    vmTreeView->setUniformRowHeights(true);
+    
+    // Click a header to sort; the order follows the values as they change on each poll.
+    // No sort indicator at first leaves the model's default order (VmModel::sort(-1)).
+    vmTreeView->header()->setSortIndicator(-1, Qt::AscendingOrder);
+    vmTreeView->setSortingEnabled(true);
     
     // --- NEW: Context Menu Setup ---
     vmTreeView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -114,18 +215,36 @@ void ProxmoxClientWindow::setupMainUI()
              this, &ProxmoxClientWindow::on_vmTreeView_customContextMenuRequested);
     // -------------------------------
     
+    // Expand folders as they appear (refreshes no longer reset the model, so
+    // folders the user collapsed stay collapsed)
+    connect(vmModel, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &parent, int first, int last) {
+        if (parent.isValid()) return;
+        for (int row = first; row <= last; ++row) {
+            vmTreeView->expand(vmModel->index(row, 0));
+        }
+    });
+    
+    // The first load (or a switch to an unrelated VM list) arrives as a model reset
+    connect(vmModel, &QAbstractItemModel::modelReset, this, [this]() {
+        QTimer::singleShot(0, this, [this]() { vmTreeView->expandAll(); });
+    });
+    
     // Connect double-click to view console/connect 
     connect(vmTreeView, &QTreeView::doubleClicked, this, &ProxmoxClientWindow::on_treeView_doubleClicked);
 
     // Initialize buttons
     refreshListButton = new QPushButton("Refresh List");
-    startVmButton = new QPushButton("Start VM"); 
+    startVmButton = new QPushButton("Start Selected");
     createFolderButton = new QPushButton("New Folder"); // NEW BUTTON
+    diagnosticsButton = new QPushButton("Diagnostics");
 
     // Connect buttons to their slots
     connect(refreshListButton, &QPushButton::clicked, this, &ProxmoxClientWindow::on_listButton_clicked);
     connect(startVmButton, &QPushButton::clicked, this, &ProxmoxClientWindow::on_startVmButton_clicked);
     connect(createFolderButton, &QPushButton::clicked, this, &ProxmoxClientWindow::on_createFolderButton_clicked); // NEW CONNECTION
+    connect(diagnosticsButton, &QPushButton::clicked, this, [this]() {
+        diagnosticsDock->setVisible(!diagnosticsDock->isVisible());
+    });
 
     // Layout the left panel with vmTreeView and buttons
     QVBoxLayout *leftLayout = new QVBoxLayout(leftPanel);
@@ -136,18 +255,69 @@ void ProxmoxClientWindow::setupMainUI()
     buttonLayout->addWidget(refreshListButton);
     buttonLayout->addWidget(startVmButton);
     buttonLayout->addWidget(createFolderButton); // ADD NEW BUTTON
+    buttonLayout->addWidget(diagnosticsButton);
+
+#if PROXMOX_TRACE_ENABLED
+    // Trace ring dump (only in builds where tracing is compiled in, see Tracing.h)
+    QPushButton *dumpTraceButton = new QPushButton("Dump Trace");
+    connect(dumpTraceButton, &QPushButton::clicked, this, [this]() {
+        const QStringList lines = TraceRing::instance().dump(500);
+        consoleLog->append(QString("--- Trace ring: last %1 events ---").arg(lines.size()));
+        for (const QString& line : lines) {
+            consoleLog->append(line);
+        }
+    });
+    buttonLayout->addWidget(dumpTraceButton);
+#endif
     
     leftLayout->addLayout(buttonLayout);
 
 
-    // 3. Right Side (VM Console/Log)
+    // 3. Right Side (details of the selected VM above the console/log)
+    detailsPane = new VmDetailsPane(metricsHistory);
+    connect(detailsPane, &VmDetailsPane::rrdDataRequested, this,
+            [this](int vmid, const QString& node, const QString& type, const QString& timeframe) {
+        emit rrdDataRequested(vmid, node, type, timeframe, false);
+    });
+    connect(apiManager, &ProxmoxApiManager::rrdDataReady, detailsPane, &VmDetailsPane::setRrdData, Qt::QueuedConnection);
+    
+    // Follow the current row; the rows above and below are prefetched so arrow-key
+    // browsing finds their charts already cached
+    connect(vmTreeView->selectionModel(), &QItemSelectionModel::currentChanged, this, [this](const QModelIndex& current) {
+        const TreeItem *item = static_cast<const TreeItem*>(current.internalPointer());
+        if (!item || item->isFolder) {
+            detailsPane->clearVm();
+            return;
+        }
+        detailsPane->showVm(vmModel->vmFor(item));
+        
+        const QString timeframe = detailsPane->timeframe();
+        if (timeframe == VmDetailsPane::LiveTimeframe) return;
+        for (const QModelIndex& neighbour : {vmTreeView->indexAbove(current), vmTreeView->indexBelow(current)}) {
+            const TreeItem *other = static_cast<const TreeItem*>(neighbour.internalPointer());
+            if (!other || other->isFolder) continue;
+            const Vm vm = vmModel->vmFor(other);
+            emit rrdDataRequested(vm.vmid, vm.node, vm.type, timeframe, true);
+        }
+    });
+
     consoleLog = new QTextEdit();
     consoleLog->setReadOnly(true);
     consoleLog->setText("Welcome to the Proxmox Client. Please refresh the VM list.");
+    if (vmModel->isStale()) {
+        consoleLog->append(QString("Showing cached inventory from %1 (greyed out) while the live list loads...")
+                               .arg(cachedAt.toString("yyyy-MM-dd HH:mm")));
+    }
+    
+    QSplitter *rightSplitter = new QSplitter(Qt::Vertical);
+    rightSplitter->addWidget(detailsPane);
+    rightSplitter->addWidget(consoleLog);
+    rightSplitter->setStretchFactor(0, 3);
+    rightSplitter->setStretchFactor(1, 1);
     
     // 4. Add panels to splitter
     splitter->addWidget(leftPanel);
-    splitter->addWidget(consoleLog);
+    splitter->addWidget(rightSplitter);
     
     // Set the splitter as the central widget
     setCentralWidget(splitter);
@@ -162,17 +332,37 @@ void ProxmoxClientWindow::on_loginButton_clicked()
     // 1. Disable button/UI
     loginButton->setEnabled(false);
     
-    // 2. Call the API Manager (using realmCombo->currentText() now)
-    apiManager->doLogin(hostEdit->text(), userEdit->text(), realmCombo->currentText(), passEdit->text());
+    // 2. Ask the API Manager (using realmCombo->currentText() now)
+    loginHost = hostEdit->text();
+    if (apiTokenCheck->isChecked()) {
+        // Accept "user!tokenname" and fill in the selected realm
+        QString tokenId = userEdit->text().trimmed();
+        if (!tokenId.contains('@') && tokenId.contains('!')) {
+            tokenId.replace(tokenId.indexOf('!'), 1, "@" + realmCombo->currentText() + "!");
+        }
+        emit apiTokenLoginRequested(hostEdit->text(), tokenId, passEdit->text());
+    } else {
+        emit loginRequested(hostEdit->text(), userEdit->text(), realmCombo->currentText(), passEdit->text());
+    }
 }
 
 void ProxmoxClientWindow::handleLoginSuccess()
 {
+    // The cached inventory belongs to another cluster: don't show it
+    if (vmModel->isStale() && loginHost != cachedHost) {
+        vmModel->setVmList(QVector<Vm>());
+        vmModel->setStale(false);
+    }
+    
+    // Guest ids are only unique per cluster, and this login may be to another one
+    metricsHistory.clear();
+    
     // 1. Transition UI from login to main view
     setupMainUI(); 
     
-    // 2. Automatically fetch the initial list
-    apiManager->fetchVmList();
+    // 2. Automatically fetch the initial list, then keep polling it
+    emit vmListRequested();
+    vmListPollTimer->start();
 }
 
 void ProxmoxClientWindow::handleLoginFailure(const QString& reason)
@@ -182,41 +372,102 @@ void ProxmoxClientWindow::handleLoginFailure(const QString& reason)
     if (consoleLog) consoleLog->append(QString("Login failed: %1").arg(reason));
 }
 
+// The row already shows the transition and the task tracker settles it; nothing to wait for here
 void ProxmoxClientWindow::handleActionSuccess(const QString& message)
 {
-    QMessageBox::information(this, "Success", message);
     if (consoleLog) consoleLog->append(QString("Action successful: %1").arg(message));
-    apiManager->fetchVmList(); // Refresh list after action
+}
+
+void ProxmoxClientWindow::handleVmActionFailed(int vmid, const QString& action, const QString& reason)
+{
+    vmModel->rollbackPendingAction(vmid);
+    if (reason == "cancelled") return; // Counted in the bulk summary
+    
+    if (consoleLog) consoleLog->append(QString("Action FAILED: %1 of VMID %2: %3").arg(action).arg(vmid).arg(reason));
+    if (activeBulkJobId == 0) {
+        QMessageBox::warning(this, tr("Action Failed"), tr("Could not %1 VMID %2: %3").arg(action).arg(vmid).arg(reason));
+    }
+}
+
+void ProxmoxClientWindow::handleTaskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus)
+{
+    if (ok) {
+        vmModel->completePendingAction(vm.vmid);
+    } else {
+        vmModel->rollbackPendingAction(vm.vmid);
+    }
+    if (!consoleLog) return;
+    if (ok) {
+        consoleLog->append(QString("Task finished: %1 of VMID %2 (%3).").arg(action).arg(vm.vmid).arg(vm.name));
+    } else {
+        consoleLog->append(QString("Task FAILED: %1 of VMID %2 (%3): %4 [%5]").arg(action).arg(vm.vmid).arg(vm.name).arg(exitStatus).arg(upid));
+    }
 }
 
 void ProxmoxClientWindow::handleVmListReady(const QVector<Vm>& vms)
 {
-    // 1. Pass the raw data to the model. This triggers beginResetModel/endResetModel internally.
-    vmModel->setVmList(vms);
+    // 1. Pass the raw data to the model. Only rows that differ are touched; selection
+    // and expansion survive, and new folders are expanded via rowsInserted (see setupMainUI).
+    bool layoutChanged = vmModel->setVmList(vms);
+    vmModel->setStale(false);
+    metricsHistory.record(vms, QDateTime::currentSecsSinceEpoch());
+    if (detailsPane) detailsPane->refreshLive();
     
-    if (vmTreeView) {
-        // Use QTimer::singleShot to defer view updates, ensuring they happen AFTER 
-        // the QTreeView has fully processed the endResetModel() signal.
+    if (vmTreeView && layoutChanged) {
+        // Use QTimer::singleShot to defer view updates until the QTreeView has
+        // processed the row changes.
         QTimer::singleShot(0, [this]() {
-            // A. Expand all items. (Essential step)
-            vmTreeView->expandAll(); 
-            
-            // C. Ensure columns are wide enough to display the data (prevents "invisible" data)
-            vmTreeView->resizeColumnToContents(0); // Name / Folder
-            vmTreeView->resizeColumnToContents(1); // VMID
-            vmTreeView->resizeColumnToContents(2); // Status
-            vmTreeView->resizeColumnToContents(3); // Type
+            // Ensure columns are wide enough to display the data (prevents "invisible" data)
+            for (int column = 0; column < VmModel::ColumnCount; ++column) {
+                vmTreeView->resizeColumnToContents(column);
+            }
         });
     }
     
-    if (consoleLog) {
-        consoleLog->append("VM list successfully loaded/refreshed.");
+    if (layoutChanged) {
+        if (lcPerf().isDebugEnabled()) {   // memoryStats() walks the whole tree
+            VmModel::MemoryStats mem = vmModel->memoryStats();
+            qCDebug(lcPerf) << "Tree memory:" << mem.vmCount << "VMs," << mem.pool.liveItems << "items in" << mem.pool.slabCount
+                    << "slabs (" << mem.pool.slabBytes << "bytes)," << mem.childArrayBytes << "bytes child arrays,"
+                    << mem.stringBytes << "bytes folder names," << mem.inventoryBytes << "bytes inventory ="
+                    << qRound(mem.bytesPerVm) << "bytes/VM; metrics history" << metricsHistory.bytes() << "bytes";
+            if (stallMonitor) qCDebug(lcPerf).noquote() << stallMonitor->summary();
+        }
+        
+        // Polls that only update values stay quiet
+        if (consoleLog) {
+            consoleLog->append("VM list successfully loaded/refreshed.");
+        }
+    }
+}
+
+/**
+ * Startup: fills the model with the last-known inventory so the tree is populated
+ * the moment the main view appears. It stays greyed out (stale) until the first
+ * live list is reconciled into it by handleVmListReady.
+ */
+void ProxmoxClientWindow::handleFolderStoreWarning(const QString& message)
+{
+    if (consoleLog) consoleLog->append(message);
+    QMessageBox::warning(this, tr("Folder Configuration"), message);
+}
+
+void ProxmoxClientWindow::handleCachedVmListReady(const QVector<Vm>& vms, const QString& host, const QDateTime& savedAt)
+{
+    cachedHost = host;
+    cachedAt = savedAt;
+    vmModel->setVmList(vms);
+    vmModel->setStale(true);
+    
+    // Offer the cached cluster as the login target if the user hasn't typed one yet
+    if (hostEdit && !host.isEmpty() && hostEdit->text() == "https://your.proxmox.host:8006") {
+        hostEdit->setText(host);
     }
 }
 
 void ProxmoxClientWindow::on_listButton_clicked()
 {
-    apiManager->fetchVmList();
+    emit vmListRequested();
 }
 
 void ProxmoxClientWindow::on_startVmButton_clicked()
@@ -224,21 +475,138 @@ void ProxmoxClientWindow::on_startVmButton_clicked()
     // Check if the main UI is set up
     if (!vmTreeView) return;
 
-    QModelIndex index = vmTreeView->currentIndex();
-    if (!index.isValid()) return;
+    runPowerAction("start", selectedVms());
+}
 
-    // Use getItem() from the model (or internalPointer())
-    TreeItem* item = static_cast<TreeItem*>(index.internalPointer());
-    
-    if (item && !item->isFolder) {
-        if (item->vmData.status.toLower() != "running") {
-            // Call the API Manager slot to perform the action
-            apiManager->performVmAction("start", item->vmData.vmid, item->vmData);
-            if (consoleLog) consoleLog->append(QString("Attempting to START VMID: %1").arg(item->vmData.vmid));
+QVector<Vm> ProxmoxClientWindow::selectedVms() const
+{
+    QVector<Vm> vms;
+    if (!vmTreeView) return vms;
+
+    QSet<int> seen;
+    auto add = [this, &vms, &seen](const TreeItem *item) {
+        if (!item || item->isFolder || seen.contains(item->vmid)) return;
+        seen.insert(item->vmid);
+        vms.append(vmModel->vmFor(item));
+    };
+
+    for (const QModelIndex& index : vmTreeView->selectionModel()->selectedRows()) {
+        const TreeItem *item = static_cast<const TreeItem*>(index.internalPointer());
+        if (!item) continue;
+        if (item->isFolder) {
+            for (const TreeItem *child : item->children) add(child);
         } else {
-            if (consoleLog) consoleLog->append(QString("VMID %1 is already running.").arg(item->vmData.vmid));
+            add(item);
+        }
+    }
+    return vms;
+}
+
+/**
+ * Filters 'vms' down to the guests the action applies to (start: not running;
+ * shutdown/stop/reboot: running), then sends them. Several VMs go out as one bulk
+ * job: the manager fans the POSTs out per node, this window shows one progress
+ * dialog and refreshes the list once when the job ends.
+ */
+void ProxmoxClientWindow::runPowerAction(const QString& action, const QVector<Vm>& vms)
+{
+    const bool wantRunning = (action != "start");
+    QVector<Vm> targets;
+    int skipped = 0;
+    int busy = 0;
+    for (const Vm& vm : vms) {
+        if (vmModel->hasPendingAction(vm.vmid)) {
+            busy++;
+            continue;
+        }
+        bool running = vm.status.toLower() == "running";
+        if (running == wantRunning) {
+            targets.append(vm);
+        } else {
+            skipped++;
+        }
+    }
+
+    if (skipped > 0 && consoleLog) {
+        consoleLog->append(QString("%1 selected VM(s) skipped: already %2.").arg(skipped).arg(wantRunning ? "stopped" : "running"));
+    }
+    if (busy > 0 && consoleLog) {
+        consoleLog->append(QString("%1 selected VM(s) skipped: an action is already in progress.").arg(busy));
+    }
+    if (targets.isEmpty()) return;
+
+    // The rows show the transition immediately; task results and refreshes settle it
+    if (targets.size() == 1) {
+        const Vm& vm = targets.first();
+        vmModel->beginPendingAction(vm.vmid, action);
+        emit vmActionRequested(action, vm.vmid, vm);
+        if (consoleLog) consoleLog->append(QString("Attempting to %1 VMID: %2").arg(action.toUpper()).arg(vm.vmid));
+        return;
+    }
+
+    if (activeBulkJobId != 0) {
+        QMessageBox::information(this, tr("Bulk Action"), tr("Another bulk action is still running."));
+        return;
+    }
+
+    if (action != "start") {
+        auto answer = QMessageBox::question(this, tr("Confirm Bulk Action"),
+                                            tr("%1 %2 guests?").arg(action.left(1).toUpper() + action.mid(1)).arg(targets.size()));
+        if (answer != QMessageBox::Yes) return;
+    }
+
+    activeBulkJobId = ++lastBulkJobId;
+    activeBulkAction = action;
+    for (const Vm& vm : targets) {
+        vmModel->beginPendingAction(vm.vmid, action);
+    }
+    emit bulkVmActionRequested(activeBulkJobId, action, targets);
+    if (consoleLog) consoleLog->append(QString("Bulk %1 of %2 VMs started.").arg(action).arg(targets.size()));
+
+    bulkProgress = new QProgressDialog(QString("%1: 0 of %2 done").arg(action).arg(targets.size()),
+                                       tr("Cancel Remaining"), 0, targets.size(), this);
+    bulkProgress->setWindowTitle(tr("Bulk Action"));
+    bulkProgress->setMinimumDuration(0);
+    bulkProgress->setAutoReset(false);
+    bulkProgress->setAutoClose(false);
+    const quint64 jobId = activeBulkJobId;
+    connect(bulkProgress, &QProgressDialog::canceled, this, [this, jobId]() {
+        emit bulkVmActionCancelRequested(jobId); // Requests already sent still complete
+    });
+    bulkProgress->setValue(0);
+}
+
+void ProxmoxClientWindow::handleBulkActionProgress(quint64 jobId, int completed, int failed, int total)
+{
+    if (jobId != activeBulkJobId || !bulkProgress) return;
+    bulkProgress->setValue(completed);
+    bulkProgress->setLabelText(failed > 0 ? QString("%1: %2 of %3 done, %4 failed").arg(activeBulkAction).arg(completed).arg(total).arg(failed)
+                                          : QString("%1: %2 of %3 done").arg(activeBulkAction).arg(completed).arg(total));
+}
+
+void ProxmoxClientWindow::handleBulkActionFinished(quint64 jobId, int succeeded, int failed, int skipped, const QStringList& errors)
+{
+    if (jobId != activeBulkJobId) return;
+    activeBulkJobId = 0;
+    if (bulkProgress) {
+        bulkProgress->close();
+        bulkProgress->deleteLater();
+        bulkProgress = nullptr;
+    }
+
+    QString summary = QString("Bulk %1 finished: %2 succeeded, %3 failed").arg(activeBulkAction).arg(succeeded).arg(failed);
+    if (skipped > 0) summary += QString(", %1 cancelled").arg(skipped);
+    if (consoleLog) {
+        consoleLog->append(summary + ".");
+        for (const QString& error : errors) {
+            consoleLog->append("  " + error);
         }
     }
+    if (failed > 0) {
+        QMessageBox::warning(this, tr("Bulk Action"), summary + tr(". See the console log for details."));
+    }
+
+    emit vmListRequested(); // One refresh for the whole job
 }
 
 void ProxmoxClientWindow::on_treeView_doubleClicked(const QModelIndex& index)
@@ -246,7 +614,7 @@ void ProxmoxClientWindow::on_treeView_doubleClicked(const QModelIndex& index)
     TreeItem* item = static_cast<TreeItem*>(index.internalPointer());
     if (item && !item->isFolder) {
         // --- THIS IS WHERE YOU START THE REMOTE DISPLAY CONNECTION ---
-        if (consoleLog) consoleLog->append(QString("Attempting to connect to console for VMID: %1").arg(item->vmData.vmid));
+        if (consoleLog) consoleLog->append(QString("Attempting to connect to console for VMID: %1").arg(item->vmid));
     }
 }
 
@@ -283,8 +651,8 @@ void ProxmoxClientWindow::on_vmTreeView_customContextMenuRequested(const QPoint
 
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     
-    // Only show the context menu on actual VM items
-    if (item && !item->isFolder) {
+    // VMs get the full menu, folders only the power actions for their VMs
+    if (item) {
         // Map the local position to global screen coordinates
         showVmContextMenu(index, vmTreeView->viewport()->mapToGlobal(pos));
     }
@@ -293,9 +661,29 @@ void ProxmoxClientWindow::on_vmTreeView_customContextMenuRequested(const QPoint
 void ProxmoxClientWindow::showVmContextMenu(const QModelIndex& index, const QPoint& globalPos)
 {
     TreeItem *vmItem = static_cast<TreeItem*>(index.internalPointer());
-    if (!vmItem || vmItem->isFolder) return;
+    if (!vmItem) return;
 
     QMenu menu(this);
+    
+    // Power actions apply to the whole selection (the right-clicked row is part of it)
+    const QVector<Vm> selection = selectedVms();
+    QMenu *powerMenu = menu.addMenu(selection.size() > 1 ? QString("Power (%1 VMs)").arg(selection.size()) : QString("Power"));
+    powerMenu->setEnabled(!selection.isEmpty());
+    const QList<QPair<QString, QString>> powerActions = {
+        {"Start", "start"}, {"Shutdown", "shutdown"}, {"Stop", "stop"}, {"Reboot", "reboot"}
+    };
+    for (const auto& powerAction : powerActions) {
+        const QString action = powerAction.second;
+        connect(powerMenu->addAction(powerAction.first), &QAction::triggered, this, [this, action, selection]() {
+            runPowerAction(action, selection);
+        });
+    }
+    
+    if (vmItem->isFolder) {
+        menu.exec(globalPos);
+        return;
+    }
+    
     QMenu *moveToFolderMenu = menu.addMenu("Move to Folder");
     
     QStringList folders = vmModel->getFolderNames();
@@ -326,20 +714,22 @@ void ProxmoxClientWindow::showVmContextMenu(const QModelIndex& index, const QPoi
             }
             
             QAction *folderAction = moveToFolderMenu->addAction(folderName);
-            // Use a lambda to capture the VMID and folder name
-            connect(folderAction, &QAction::triggered, this, [this, vmItem, folderName]() {
-                if (vmModel->assignVmToFolder(vmItem->vmData.vmid, folderName)) {
-                    if (consoleLog) consoleLog->append(QString("VM '%1' assigned to folder '%2'.").arg(vmItem->name).arg(folderName));
+            // Capture the VMID, not the item: menu.exec() runs a nested event loop in which a
+            // poll may remove the item (and the pool may hand its slot to another VM)
+            const int vmid = vmItem->vmid;
+            connect(folderAction, &QAction::triggered, this, [this, vmid, folderName]() {
+                const TreeItem *item = vmModel->findVmItem(vmid);
+                const QString vmName = item ? vmModel->displayName(item) : QString::number(vmid);
+                if (item && vmModel->assignVmToFolder(vmid, folderName)) {
+                    emit vmFolderAssignmentRequested(vmid, folderName); // Persist it
+                    if (consoleLog) consoleLog->append(QString("VM '%1' assigned to folder '%2'.").arg(vmName).arg(folderName));
                 } else {
                     QMessageBox::warning(this, tr("Move Error"), 
-                                         tr("Failed to move VM %1 to folder %2. Check console log.").arg(vmItem->name).arg(folderName));
+                                         tr("Failed to move VM %1 to folder %2. Check console log.").arg(vmName).arg(folderName));
                 }
             });
         }
     }
     
-    // You can add other VM-specific actions here (e.g., Start/Stop)
-    // menu.addAction(startVmButton->text());
-    
     menu.exec(globalPos);
 }
\ No newline at end of file
@@ -8,9 +8,18 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QComboBox> // NEW: Include QComboBox for the Realm dropdown
+#include <QCheckBox>
 #include <QMenu>     // NEW: Include QMenu for context menu
+#include <QThread>
+#include <QDockWidget>
+#include <QProgressDialog>
+#include <QTimer>
 #include "ProxmoxApiManager.h"
 #include "VmModel.h"
+#include "MetricsHistory.h"
+#include "StallMonitor.h"
+#include "DiagnosticsPanel.h"
+#include "VmDetailsPane.h"
 
 class ProxmoxClientWindow : public QMainWindow
 {
@@ -20,11 +29,30 @@ public:
         explicit ProxmoxClientWindow(QWidget *parent = nullptr);
         ~ProxmoxClientWindow();
 
+signals:
+        // Requests to the API manager. It lives on managerThread, so these are only
+        // ever delivered as queued calls; results come back through its own signals.
+        void loginRequested(const QString& host, const QString& username, const QString& realm, const QString& password);
+        void apiTokenLoginRequested(const QString& host, const QString& tokenId, const QString& secret);
+        void vmListRequested();
+        void vmActionRequested(const QString& action, int vmid, const Vm& vm_data);
+        void vmFolderAssignmentRequested(int vmid, const QString& folderName);
+        void bulkVmActionRequested(quint64 jobId, const QString& action, const QVector<Vm>& vms);
+        void bulkVmActionCancelRequested(quint64 jobId);
+        // prefetch = true only warms the manager's RRD cache (neighbours of the selection)
+        void rrdDataRequested(int vmid, const QString& node, const QString& type, const QString& timeframe, bool prefetch);
+
 private slots:
         void handleLoginSuccess();
         void handleLoginFailure(const QString& reason);
         void handleVmListReady(const QVector<Vm>& vms);
+        void handleCachedVmListReady(const QVector<Vm>& vms, const QString& host, const QDateTime& savedAt);
+        void handleFolderStoreWarning(const QString& message);
         void handleActionSuccess(const QString& message);
+        void handleVmActionFailed(int vmid, const QString& action, const QString& reason);
+        void handleBulkActionProgress(quint64 jobId, int completed, int failed, int total);
+        void handleBulkActionFinished(quint64 jobId, int succeeded, int failed, int skipped, const QStringList& errors);
+        void handleTaskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus);
         
         // User interactions
         void on_loginButton_clicked();
@@ -42,23 +70,50 @@ private:
         QTreeView *vmTreeView = nullptr; // Initialize pointers to nullptr to prevent Seg Fault on access
         QTextEdit *consoleLog = nullptr;
         QSplitter *splitter = nullptr;
+        VmDetailsPane *detailsPane = nullptr;    // Usage charts of the selected VM, above consoleLog
         
         // Login form elements (Declared as members to prevent Seg Fault)
         QLineEdit *hostEdit = nullptr;
         QLineEdit *userEdit = nullptr;
         QComboBox *realmCombo = nullptr; 
         QLineEdit *passEdit = nullptr;
+        QCheckBox *apiTokenCheck = nullptr;  // Username/password fields hold token ID/secret when checked
         QPushButton *loginButton = nullptr;
 
     // --- MAIN UI BUTTONS ---
     QPushButton *startVmButton = nullptr; // Ensure this is a member for accessibility
     QPushButton *refreshListButton = nullptr; // Ensure this is a member for consistency
     QPushButton *createFolderButton = nullptr; // NEW: Button to create a new folder
+    QPushButton *diagnosticsButton = nullptr;  // Shows/hides diagnosticsDock
     // -----------------------
 
         // --- Core Logic ---
-        ProxmoxApiManager *apiManager = nullptr;
+        ProxmoxApiManager *apiManager = nullptr; // Lives on managerThread; never call it directly
+        QThread *managerThread = nullptr;
         VmModel *vmModel = nullptr;
+        MetricsHistory metricsHistory;           // Usage history of every guest, fed by each live VM list
+        StallMonitor *stallMonitor = nullptr;    // Measures GUI event loop stalls; only with PROXMOX_STALL_MONITOR=1
+        QTimer *vmListPollTimer = nullptr;       // Periodic vmListRequested while logged in
+        DiagnosticsPanel *diagnosticsPanel = nullptr;
+        QDockWidget *diagnosticsDock = nullptr;
+        
+        // Cached inventory shown until the first live list arrives
+        QString cachedHost;
+        QDateTime cachedAt;
+        QString loginHost;                        // Host of the login in progress / last login
+        
+        // Bulk power action in progress (one at a time)
+        QProgressDialog *bulkProgress = nullptr;
+        quint64 lastBulkJobId = 0;
+        quint64 activeBulkJobId = 0;              // 0 = none
+        QString activeBulkAction;
+        
+        void stopManagerThread();
+        
+        // VMs in the tree selection; a selected folder contributes all of its VMs
+        QVector<Vm> selectedVms() const;
+        // Single VM: the plain action path. Several: one bulk job with a progress dialog.
+        void runPowerAction(const QString& action, const QVector<Vm>& vms);
         
         // --- Helper functions for UI setup ---
         void setupLoginUI();
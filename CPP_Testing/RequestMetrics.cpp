@@ -0,0 +1,152 @@
+#include "RequestMetrics.h"
+#include <QtAlgorithms>
+#include <cmath>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// --- LatencyHistogram ---
+
+int LatencyHistogram::bucketFor(qint64 valueUs)
+{
+    if (valueUs < SubBuckets) return valueUs < 0 ? 0 : static_cast<int>(valueUs);
+
+    int magnitude = 63 - static_cast<int>(qCountLeadingZeroBits(static_cast<quint64>(valueUs)));
+    if (magnitude >= MaxMagnitude) return BucketCount - 1;
+
+    int shift = magnitude - SubBucketBits;
+    int sub = static_cast<int>(valueUs >> shift) - SubBuckets;
+    return SubBuckets + shift * SubBuckets + sub;
+}
+
+qint64 LatencyHistogram::lowerBound(int bucket)
+{
+    if (bucket < SubBuckets) return bucket;
+    int shift = (bucket - SubBuckets) / SubBuckets;
+    int sub = (bucket - SubBuckets) % SubBuckets;
+    return static_cast<qint64>(SubBuckets + sub) << shift;
+}
+
+qint64 LatencyHistogram::upperBound(int bucket)
+{
+    if (bucket < SubBuckets) return bucket;
+    int shift = (bucket - SubBuckets) / SubBuckets;
+    int sub = (bucket - SubBuckets) % SubBuckets;
+    return (static_cast<qint64>(SubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 valueUs)
+{
+    if (valueUs < 0) valueUs = 0;
+    counts[bucketFor(valueUs)]++;
+    if (total == 0 || valueUs < minValue) minValue = valueUs;
+    if (valueUs > maxValue) maxValue = valueUs;
+    sum += valueUs;
+    total++;
+}
+
+qint64 LatencyHistogram::percentile(double quantile) const
+{
+    if (total == 0) return 0;
+
+    quint64 target = static_cast<quint64>(std::ceil(qBound(0.0, quantile, 1.0) * total));
+    if (target == 0) target = 1;
+
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= target) return qMin(upperBound(i), maxValue);
+    }
+    return maxValue;
+}
+
+// --- RequestMetrics ---
+
+const char *RequestMetrics::phaseName(Phase phase)
+{
+    switch (phase) {
+        case Dns: return "dns";
+        case Connect: return "connect";
+        case Tls: return "tls";
+        case Server: return "server";
+        case Transfer: return "transfer";
+        case Total: return "total";
+        default: return "?";
+    }
+}
+
+void RequestMetrics::record(const std::string& host, const std::string& label, const ApiTiming& timing, bool transportError, long httpCode)
+{
+    QMutexLocker locker(&mutex);
+    EndpointMetrics& metrics = endpoints[std::make_pair(host, label)];
+
+    metrics.requests++;
+    if (transportError) metrics.transportErrors++;
+    else if (httpCode >= 400) metrics.httpErrors++;
+    metrics.bytesDown += timing.bytesDown;
+    metrics.bytesUp += timing.bytesUp;
+
+    // Failed transfers still tell us how far they got, but their later phases are meaningless
+    metrics.phases[Dns].record(timing.dnsUs);
+    if (timing.newConnection) {
+        metrics.newConnections++;
+        metrics.phases[Connect].record(timing.connectUs);
+        if (timing.tlsUs > 0) metrics.phases[Tls].record(timing.tlsUs);
+    }
+    if (!transportError) {
+        metrics.phases[Server].record(timing.serverUs);
+        metrics.phases[Transfer].record(timing.transferUs);
+    }
+    metrics.phases[Total].record(timing.totalUs);
+}
+
+std::string RequestMetrics::toJson() const
+{
+    json out;
+    out["unit"] = "us";
+    out["endpoints"] = json::array();
+
+    QMutexLocker locker(&mutex);
+    for (const auto& entry : endpoints) {
+        const EndpointMetrics& metrics = entry.second;
+        json endpoint = {
+            {"host", entry.first.first},
+            {"label", entry.first.second},
+            {"requests", metrics.requests},
+            {"newConnections", metrics.newConnections},
+            {"transportErrors", metrics.transportErrors},
+            {"httpErrors", metrics.httpErrors},
+            {"bytesDown", metrics.bytesDown},
+            {"bytesUp", metrics.bytesUp},
+        };
+
+        json phases = json::object();
+        for (int p = 0; p < PhaseCount; ++p) {
+            const LatencyHistogram& histogram = metrics.phases[p];
+            json buckets = json::array();
+            histogram.forEachBucket([&buckets](qint64 lower, quint64 count) {
+                buckets.push_back({lower, count});
+            });
+            phases[phaseName(static_cast<Phase>(p))] = {
+                {"count", histogram.count()},
+                {"min", histogram.min()},
+                {"mean", histogram.mean()},
+                {"p50", histogram.percentile(0.50)},
+                {"p90", histogram.percentile(0.90)},
+                {"p99", histogram.percentile(0.99)},
+                {"p999", histogram.percentile(0.999)},
+                {"max", histogram.max()},
+                {"buckets", buckets},
+            };
+        }
+        endpoint["phases"] = phases;
+        out["endpoints"].push_back(endpoint);
+    }
+    return out.dump(2);
+}
+
+void RequestMetrics::reset()
+{
+    QMutexLocker locker(&mutex);
+    endpoints.clear();
+}
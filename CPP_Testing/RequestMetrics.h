@@ -0,0 +1,101 @@
+#ifndef REQUESTMETRICS_H
+#define REQUESTMETRICS_H
+
+#include <QMutex>
+#include <QtGlobal>
+#include <array>
+#include <map>
+#include <string>
+#include <utility>
+
+// --- PER-REQUEST TIMING ---
+// Phase durations of one transfer, derived from libcurl's cumulative timers.
+// Connect and TLS are 0 when the request reused a pooled connection.
+struct ApiTiming
+{
+    qint64 dnsUs = 0;          // Name lookup (CURLINFO_NAMELOOKUP_TIME_T)
+    qint64 connectUs = 0;      // TCP handshake (CONNECT_TIME - NAMELOOKUP_TIME)
+    qint64 tlsUs = 0;          // TLS handshake (APPCONNECT_TIME - CONNECT_TIME)
+    qint64 serverUs = 0;       // Request sent -> first response byte (STARTTRANSFER_TIME - PRETRANSFER_TIME)
+    qint64 transferUs = 0;     // First byte -> done (TOTAL_TIME - STARTTRANSFER_TIME)
+    qint64 totalUs = 0;        // CURLINFO_TOTAL_TIME_T
+    qint64 bytesDown = 0;
+    qint64 bytesUp = 0;
+    bool newConnection = false;
+};
+
+// --- LatencyHistogram ---
+// HDR-style log-linear histogram of microsecond values: exact below 32 us, then 32
+// sub-buckets per power of two (about 3% relative error) up to ~19 hours. Fixed
+// size, no allocation on record(), and mergeable by adding counts.
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxMagnitude = 36;   // Values >= 2^36 us land in the last bucket
+    static constexpr int BucketCount = SubBuckets + (MaxMagnitude - SubBucketBits) * SubBuckets;
+
+    void record(qint64 valueUs);
+
+    quint64 count() const { return total; }
+    qint64 min() const { return total ? minValue : 0; }
+    qint64 max() const { return maxValue; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Upper bound of the bucket holding the given quantile (0..1), capped at max()
+    qint64 percentile(double quantile) const;
+
+    // Non-empty buckets as (lower bound, count) pairs, for export
+    template<class F> void forEachBucket(F visit) const {
+        for (int i = 0; i < BucketCount; ++i) {
+            if (counts[i]) visit(lowerBound(i), counts[i]);
+        }
+    }
+
+    static int bucketFor(qint64 valueUs);
+    static qint64 lowerBound(int bucket);
+    static qint64 upperBound(int bucket);
+
+private:
+    std::array<quint64, BucketCount> counts{};
+    quint64 total = 0;
+    qint64 sum = 0;
+    qint64 minValue = 0;
+    qint64 maxValue = 0;
+};
+
+// --- RequestMetrics ---
+// Timing and volume statistics per (endpoint host, request label). Recorded by the
+// request engine's network thread; read from any thread. Thread-safe.
+class RequestMetrics
+{
+public:
+    enum Phase { Dns, Connect, Tls, Server, Transfer, Total, PhaseCount };
+    static const char *phaseName(Phase phase);
+
+    struct EndpointMetrics
+    {
+        std::array<LatencyHistogram, PhaseCount> phases;
+        quint64 requests = 0;
+        quint64 newConnections = 0;
+        quint64 transportErrors = 0;   // curl-level failures
+        quint64 httpErrors = 0;        // HTTP status >= 400
+        qint64 bytesDown = 0;
+        qint64 bytesUp = 0;
+    };
+
+    void record(const std::string& host, const std::string& label, const ApiTiming& timing, bool transportError, long httpCode);
+
+    // Everything recorded so far as JSON (per endpoint: counters and, per phase,
+    // count/min/mean/p50/p90/p99/p99.9/max plus the raw buckets)
+    std::string toJson() const;
+
+    void reset();
+
+private:
+    mutable QMutex mutex;
+    std::map<std::pair<std::string, std::string>, EndpointMetrics> endpoints; // (host, label)
+};
+
+#endif // REQUESTMETRICS_H
@@ -0,0 +1,136 @@
+#include "RrdFetcher.h"
+#include <QDebug>
+#include <limits>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// --- CONSTANTS ---
+const int MAX_CACHED_SERIES = 256;    // Guest/timeframe pairs kept; the least recently used goes first
+
+// --- RrdSeries ---
+
+void RrdSeries::append(qint64 when, double cpuValue, double memValue, double maxmemValue, double netinValue,
+                       double netoutValue, double diskreadValue, double diskwriteValue)
+{
+    time.append(when);
+    cpu.append(cpuValue);
+    mem.append(memValue);
+    maxmem.append(maxmemValue);
+    netin.append(netinValue);
+    netout.append(netoutValue);
+    diskread.append(diskreadValue);
+    diskwrite.append(diskwriteValue);
+}
+
+// --- RrdFetcher ---
+
+RrdFetcher::RrdFetcher(Fetch fetch, QObject *parent)
+    : QObject(parent), fetch(std::move(fetch))
+{
+}
+
+bool RrdFetcher::isTimeframe(const QString& timeframe)
+{
+    return freshSecs(timeframe) > 0;
+}
+
+// About one step of the server's RRD archive for the timeframe (year: capped at a day)
+int RrdFetcher::freshSecs(const QString& timeframe)
+{
+    if (timeframe == "hour") return 60;
+    if (timeframe == "day") return 30 * 60;
+    if (timeframe == "week") return 3 * 60 * 60;
+    if (timeframe == "month") return 12 * 60 * 60;
+    if (timeframe == "year") return 24 * 60 * 60;
+    return 0;
+}
+
+bool RrdFetcher::parse(const std::string& body, RrdSeries& series, QString *error)
+{
+    json response = json::parse(body, nullptr, false);
+    if (body.empty() || response.is_discarded() || !response.contains("data") || !response["data"].is_array()) {
+        if (error) *error = body.empty() ? "request failed" : "malformed response";
+        return false;
+    }
+
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    auto number = [missing](const json& row, const char *key) {
+        auto it = row.find(key);
+        return (it != row.end() && it->is_number()) ? it->get<double>() : missing;
+    };
+
+    for (const json& row : response["data"]) {
+        if (!row.is_object() || !row.contains("time") || !row["time"].is_number()) continue;
+        series.append(row["time"].get<qint64>(), number(row, "cpu"), number(row, "mem"), number(row, "maxmem"),
+                      number(row, "netin"), number(row, "netout"), number(row, "diskread"), number(row, "diskwrite"));
+    }
+    return true;
+}
+
+void RrdFetcher::request(int vmid, const QString& node, const QString& type, const QString& timeframe, bool notify)
+{
+    if (!isTimeframe(timeframe) || node.isEmpty() || (type != "qemu" && type != "lxc")) {
+        if (notify) emit ready(vmid, timeframe, RrdSeries(), QString("no RRD data for timeframe '%1'").arg(timeframe));
+        return;
+    }
+
+    const Key key(vmid, timeframe);
+    if (!entries.count(key)) evictIfFull();
+    Entry& entry = entries[key];
+    entry.lastUsed = ++useCounter;
+
+    const bool loaded = entry.age.isValid();
+    if (loaded && entry.age.elapsed() < freshSecs(timeframe) * 1000LL) {
+        if (notify) emit ready(vmid, timeframe, entry.series, QString());
+        return;
+    }
+    // Expired: show what we have while the refresh runs
+    if (loaded && notify) emit ready(vmid, timeframe, entry.series, QString());
+
+    entry.notify = entry.notify || notify;
+    if (entry.inFlight) return;
+    entry.inFlight = true;
+
+    const QString path = QString("/nodes/%1/%2/%3/rrddata?timeframe=%4&cf=AVERAGE").arg(node).arg(type).arg(vmid).arg(timeframe);
+    const quint64 requestGeneration = generation;
+    fetch(path.toStdString(), [this, key, requestGeneration](const std::string& body) {
+        if (requestGeneration != generation) return;
+        auto it = entries.find(key);
+        if (it == entries.end()) return;
+        Entry& entry = it->second;
+        entry.inFlight = false;
+
+        RrdSeries series;
+        QString error;
+        const bool ok = parse(body, series, &error);
+        const bool notify = entry.notify;
+        entry.notify = false;
+        if (ok) {
+            entry.series = series;
+            entry.age.start();
+        } else {
+            qWarning() << "RRD data for VMID" << key.first << "(" << key.second << ") unavailable:" << error;
+            if (!entry.age.isValid()) entries.erase(it);   // Don't keep empty entries around
+        }
+        if (notify) emit ready(key.first, key.second, series, error);
+    });
+}
+
+void RrdFetcher::clear()
+{
+    generation++;
+    entries.clear();
+}
+
+void RrdFetcher::evictIfFull()
+{
+    if (static_cast<int>(entries.size()) < MAX_CACHED_SERIES) return;
+
+    auto victim = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second.inFlight) continue;
+        if (victim == entries.end() || it->second.lastUsed < victim->second.lastUsed) victim = it;
+    }
+    if (victim != entries.end()) entries.erase(victim);
+}
@@ -0,0 +1,82 @@
+#ifndef RRDFETCHER_H
+#define RRDFETCHER_H
+
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+// --- RrdSeries ---
+// One /nodes/{node}/{type}/{vmid}/rrddata response, column by column. Rows where the
+// guest reported nothing (e.g. it was stopped) hold NaN.
+struct RrdSeries
+{
+    QVector<qint64> time;                 // Seconds since the epoch, ascending
+    QVector<double> cpu;                  // Fraction (0..1) of the guest's vCPUs
+    QVector<double> mem, maxmem;          // Bytes
+    QVector<double> netin, netout;        // Bytes per second, averaged over the RRD step
+    QVector<double> diskread, diskwrite;  // Bytes per second
+
+    int size() const { return time.size(); }
+    void append(qint64 when, double cpuValue, double memValue, double maxmemValue, double netinValue,
+                double netoutValue, double diskreadValue, double diskwriteValue);
+};
+
+Q_DECLARE_METATYPE(RrdSeries)
+
+// --- RrdFetcher ---
+// Loads the PVE RRD statistics of single guests on demand and caches them per guest
+// and timeframe. An entry stays fresh for about one RRD step of its timeframe (no new
+// row can appear sooner). An expired entry is still delivered at once and then
+// refreshed, so re-selecting a guest always shows something immediately. Prefetches
+// only warm the cache. Lives on (and must only be used from) the API manager's thread.
+class RrdFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Issues an authenticated GET for an API path; the callback gets the body, or "" on failure
+    using Fetch = std::function<void(const std::string& path, std::function<void(const std::string&)> onDone)>;
+
+    explicit RrdFetcher(Fetch fetch, QObject *parent = nullptr);
+
+    // 'timeframe' is one of hour, day, week, month, year. With notify = false (a prefetch)
+    // nothing is emitted unless a notifying request joins while it is in flight.
+    void request(int vmid, const QString& node, const QString& type, const QString& timeframe, bool notify);
+    // Forgets every entry (the session changed)
+    void clear();
+
+    static bool isTimeframe(const QString& timeframe);
+    static int freshSecs(const QString& timeframe);
+    // Parses an rrddata response; returns false (and sets 'error') on malformed input
+    static bool parse(const std::string& body, RrdSeries& series, QString *error = nullptr);
+
+signals:
+    // 'error' is empty on success. May be emitted twice for one request: cached (expired) data, then fresh.
+    void ready(int vmid, const QString& timeframe, const RrdSeries& series, const QString& error);
+
+private:
+    struct Entry
+    {
+        RrdSeries series;
+        QElapsedTimer age;          // Invalid until the first successful load
+        bool inFlight = false;
+        bool notify = false;        // Someone is waiting for the request in flight
+        quint64 lastUsed = 0;       // For eviction
+    };
+    using Key = std::pair<int, QString>;   // vmid, timeframe
+
+    void evictIfFull();
+
+    Fetch fetch;
+    std::map<Key, Entry> entries;
+    quint64 generation = 0;   // Bumped by clear(); replies of an older session are ignored
+    quint64 useCounter = 0;
+};
+
+#endif // RRDFETCHER_H
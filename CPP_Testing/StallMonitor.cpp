@@ -0,0 +1,48 @@
+#include "StallMonitor.h"
+#include "Tracing.h"
+
+// --- CONSTANTS ---
+const int TICK_INTERVAL_MS = 20;     // How often the event loop is probed
+const int STALL_THRESHOLD_MS = 50;   // Lateness counted as a user-visible stall
+
+StallMonitor::StallMonitor(QObject *parent)
+    : QObject(parent)
+{
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(TICK_INTERVAL_MS);
+    connect(&timer, &QTimer::timeout, this, &StallMonitor::tick);
+
+    reset();
+    timer.start();
+}
+
+void StallMonitor::reset()
+{
+    max_stall_ms = 0;
+    total_stall_ms = 0;
+    stall_count = 0;
+    sinceLastTick.start();
+    observed.start();
+}
+
+void StallMonitor::tick()
+{
+    qint64 late = sinceLastTick.restart() - TICK_INTERVAL_MS;
+    if (late < STALL_THRESHOLD_MS) return;
+
+    stall_count++;
+    total_stall_ms += late;
+    if (late > max_stall_ms) max_stall_ms = late;
+
+    PVE_TRACE_EVENT("MainThread::stall", late, 0);
+}
+
+QString StallMonitor::summary() const
+{
+    return QString("Main thread: %1 stalls >= %2 ms in %3 s, %4 ms stalled in total, worst %5 ms")
+        .arg(stall_count)
+        .arg(STALL_THRESHOLD_MS)
+        .arg(observed.elapsed() / 1000)
+        .arg(total_stall_ms)
+        .arg(max_stall_ms);
+}
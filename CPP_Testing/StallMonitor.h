@@ -0,0 +1,40 @@
+#ifndef STALLMONITOR_H
+#define STALLMONITOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTimer>
+
+// --- StallMonitor ---
+// Measures how long the thread it lives on (the GUI thread) fails to service its
+// event loop. A short repeating timer records how late each tick fires; any delay
+// beyond the tick interval is time during which the UI could not repaint or react.
+// The probe wakes the thread 50 times a second, so it is only created on request.
+class StallMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StallMonitor(QObject *parent = nullptr);
+
+    void reset();
+
+    qint64 maxStallMs() const { return max_stall_ms; }
+    qint64 totalStallMs() const { return total_stall_ms; }
+    int stallCount() const { return stall_count; }   // Ticks delayed by at least STALL_THRESHOLD_MS
+    QString summary() const;
+
+private slots:
+    void tick();
+
+private:
+    QTimer timer;
+    QElapsedTimer sinceLastTick;
+    QElapsedTimer observed;
+    qint64 max_stall_ms = 0;
+    qint64 total_stall_ms = 0;
+    int stall_count = 0;
+};
+
+#endif // STALLMONITOR_H
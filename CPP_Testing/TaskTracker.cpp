@@ -0,0 +1,216 @@
+#include "TaskTracker.h"
+#include <QDebug>
+#include <QStringList>
+#include <QUrl>
+#include "Tracing.h"
+
+// --- CONSTANTS ---
+const int MIN_POLL_INTERVAL_MS = 500;     // New tasks: most power actions end within a few seconds
+const int MAX_POLL_INTERVAL_MS = 5000;
+const double POLL_BACKOFF = 1.5;          // Interval growth per round in which nothing finished
+const int LISTING_THRESHOLD = 4;          // More outstanding tasks than this on a node: poll the task list
+const int MIN_LISTING_LIMIT = 500;
+const int MAX_FAILED_POLLS = 10;          // Give up on a task whose status cannot be read
+
+TaskTracker::TaskTracker(Fetch fetch, QObject *parent)
+    : QObject(parent), fetch(std::move(fetch))
+{
+}
+
+QString TaskTracker::nodeOf(const QString& upid)
+{
+    const QStringList fields = upid.split(':');
+    return (fields.size() >= 8 && fields[0] == "UPID") ? fields[1] : QString();
+}
+
+qint64 TaskTracker::startTimeOf(const QString& upid)
+{
+    const QStringList fields = upid.split(':');
+    if (fields.size() < 8 || fields[0] != "UPID") return 0;
+    bool ok = false;
+    qint64 start = fields[4].toLongLong(&ok, 16);
+    return ok ? start : 0;
+}
+
+bool TaskTracker::track(const QString& upid, const Vm& vm, const QString& action)
+{
+    const QString node = nodeOf(upid);
+    const qint64 startTime = startTimeOf(upid);
+    if (node.isEmpty() || startTime == 0) {
+        qWarning() << "Not tracking malformed task ID" << upid;
+        return false;
+    }
+
+    Node& state = nodes[node];
+    Task& task = state.tasks[upid];
+    task.vm = vm;
+    task.action = action;
+    task.startTime = startTime;
+
+    if (!state.timer) {
+        state.timer = new QTimer(this);
+        state.timer->setSingleShot(true);
+        connect(state.timer, &QTimer::timeout, this, [this, node]() { poll(node); });
+    }
+
+    // A new task resets the node to the fast interval (a round in flight reschedules itself)
+    state.intervalMs = MIN_POLL_INTERVAL_MS;
+    if (state.pending == 0 && (!state.timer->isActive() || state.timer->remainingTime() > MIN_POLL_INTERVAL_MS)) {
+        state.timer->start(MIN_POLL_INTERVAL_MS);
+    }
+    PVE_TRACE_EVENT("TaskTracker::track", vm.vmid, static_cast<int>(state.tasks.size()));
+    return true;
+}
+
+void TaskTracker::clear()
+{
+    generation++;
+    for (auto& entry : nodes) {
+        delete entry.second.timer;
+    }
+    nodes.clear();
+}
+
+int TaskTracker::outstanding() const
+{
+    int count = 0;
+    for (const auto& entry : nodes) {
+        count += static_cast<int>(entry.second.tasks.size());
+    }
+    return count;
+}
+
+// --- POLLING ---
+
+void TaskTracker::poll(const QString& node)
+{
+    auto it = nodes.find(node);
+    if (it == nodes.end() || it->second.pending > 0) return;
+
+    Node& state = it->second;
+    state.progressed = false;
+    if (static_cast<int>(state.tasks.size()) > LISTING_THRESHOLD) {
+        pollListing(node, state);
+    } else {
+        pollEach(node, state);
+    }
+}
+
+void TaskTracker::pollEach(const QString& node, Node& state)
+{
+    state.pending = static_cast<int>(state.tasks.size());
+    for (const auto& entry : state.tasks) {
+        const QString upid = entry.first;
+        const QString path = QString("/nodes/%1/tasks/%2/status").arg(node).arg(QString::fromUtf8(QUrl::toPercentEncoding(upid)));
+        polls++;
+
+        quint64 pollGeneration = generation;
+        fetch(path.toStdString(), [this, node, upid, pollGeneration](const std::string& body) {
+            if (pollGeneration != generation) return;
+            auto it = nodes.find(node);
+            if (it == nodes.end()) return;
+            Node& state = it->second;
+
+            json response = json::parse(body, nullptr, false);
+            if (body.empty() || response.is_discarded() || !response.contains("data") || !response["data"].is_object()) {
+                pollFailed(state, upid);
+            } else {
+                const json& data = response["data"];
+                if (data.value("status", std::string()) == "stopped") {
+                    QString exitStatus = QString::fromStdString(data.value("exitstatus", std::string("unknown")));
+                    finish(state, upid, exitStatus == "OK", exitStatus);
+                } else if (state.tasks.count(upid)) {
+                    state.tasks[upid].failedPolls = 0;
+                }
+            }
+
+            if (--state.pending == 0) endRound(node);
+        });
+    }
+}
+
+/**
+ * @brief One request for all of a node's tasks. Finished tasks carry "endtime" and
+ * "status" ("OK" or the error text); running ones (source=all) have neither.
+ */
+void TaskTracker::pollListing(const QString& node, Node& state)
+{
+    qint64 since = 0;
+    for (const auto& entry : state.tasks) {
+        if (since == 0 || entry.second.startTime < since) since = entry.second.startTime;
+    }
+    int limit = qMax(MIN_LISTING_LIMIT, 4 * static_cast<int>(state.tasks.size()));
+    const QString path = QString("/nodes/%1/tasks?source=all&since=%2&limit=%3").arg(node).arg(since).arg(limit);
+
+    state.pending = 1;
+    polls++;
+
+    quint64 pollGeneration = generation;
+    fetch(path.toStdString(), [this, node, pollGeneration](const std::string& body) {
+        if (pollGeneration != generation) return;
+        auto it = nodes.find(node);
+        if (it == nodes.end()) return;
+        Node& state = it->second;
+
+        json response = json::parse(body, nullptr, false);
+        if (body.empty() || response.is_discarded() || !response.contains("data") || !response["data"].is_array()) {
+            std::vector<QString> upids;
+            for (const auto& entry : state.tasks) upids.push_back(entry.first);
+            for (const QString& upid : upids) pollFailed(state, upid);
+        } else {
+            for (const json& entry : response["data"]) {
+                if (!entry.is_object() || !entry.contains("endtime")) continue;
+                QString upid = QString::fromStdString(entry.value("upid", std::string()));
+                if (!state.tasks.count(upid)) continue;
+                QString exitStatus = QString::fromStdString(entry.value("status", std::string("unknown")));
+                finish(state, upid, exitStatus == "OK", exitStatus);
+            }
+            for (auto& entry : state.tasks) entry.second.failedPolls = 0;
+        }
+
+        state.pending = 0;
+        endRound(node);
+    });
+}
+
+void TaskTracker::finish(Node& state, const QString& upid, bool ok, const QString& exitStatus)
+{
+    auto it = state.tasks.find(upid);
+    if (it == state.tasks.end()) return;
+
+    Task task = it->second;
+    state.tasks.erase(it);
+    state.progressed = true;
+    if (!ok) qWarning() << "Task" << upid << "failed:" << exitStatus;
+    emit taskFinished(upid, task.vm, task.action, ok, exitStatus);
+}
+
+void TaskTracker::pollFailed(Node& state, const QString& upid)
+{
+    auto it = state.tasks.find(upid);
+    if (it == state.tasks.end()) return;
+    if (++it->second.failedPolls >= MAX_FAILED_POLLS) {
+        finish(state, upid, false, QString("status unavailable after %1 polls").arg(MAX_FAILED_POLLS));
+    }
+}
+
+void TaskTracker::endRound(const QString& node)
+{
+    auto it = nodes.find(node);
+    if (it == nodes.end()) return;
+    Node& state = it->second;
+
+    if (state.tasks.empty()) {
+        delete state.timer;
+        nodes.erase(it);
+        return;
+    }
+
+    // Something just finished: its siblings (same batch) are likely close behind
+    if (state.progressed) {
+        state.intervalMs = MIN_POLL_INTERVAL_MS;
+    } else {
+        state.intervalMs = qMin(MAX_POLL_INTERVAL_MS, qRound(state.intervalMs * POLL_BACKOFF));
+    }
+    state.timer->start(state.intervalMs);
+}
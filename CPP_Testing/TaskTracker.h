@@ -0,0 +1,76 @@
+#ifndef TASKTRACKER_H
+#define TASKTRACKER_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <functional>
+#include <map>
+#include <string>
+#include "ProxmoxApiManager.h" // For Vm struct
+
+// --- TaskTracker ---
+// Follows the PVE tasks (UPIDs) this client starts until they end. Tasks are grouped
+// by the node running them and each node has a single poll loop, however many tasks
+// it runs: a few outstanding tasks are checked one by one (/tasks/{upid}/status),
+// more than that through one /nodes/{node}/tasks listing per round. Each node's
+// interval starts short and backs off while none of its tasks finish.
+// Lives on (and must only be used from) the API manager's thread.
+class TaskTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Issues an authenticated GET for an API path; the callback gets the body, or "" on failure
+    using Fetch = std::function<void(const std::string& path, std::function<void(const std::string&)> onDone)>;
+
+    explicit TaskTracker(Fetch fetch, QObject *parent = nullptr);
+
+    // Starts following 'upid', started by 'action' on 'vm'. Returns false for a malformed UPID.
+    bool track(const QString& upid, const Vm& vm, const QString& action);
+    // Forgets every task (the session changed)
+    void clear();
+
+    int outstanding() const;
+    quint64 pollRequests() const { return polls; }
+
+    // "UPID:node:pid:pstart:starttime:type:id:user:" -> node, start time (epoch secs; 0 if malformed)
+    static QString nodeOf(const QString& upid);
+    static qint64 startTimeOf(const QString& upid);
+
+signals:
+    // 'exitStatus' is "OK" on success, otherwise the task's error text
+    void taskFinished(const QString& upid, const Vm& vm, const QString& action, bool ok, const QString& exitStatus);
+
+private:
+    struct Task
+    {
+        Vm vm;
+        QString action;
+        qint64 startTime = 0;
+        int failedPolls = 0;       // Consecutive polls that returned nothing
+    };
+
+    struct Node
+    {
+        std::map<QString, Task> tasks;   // upid -> task
+        QTimer *timer = nullptr;         // Single-shot, starts the next round
+        int intervalMs = 0;
+        int pending = 0;                 // Requests of the current round still outstanding
+        bool progressed = false;         // A task finished during the current round
+    };
+
+    void poll(const QString& node);
+    void pollEach(const QString& node, Node& state);
+    void pollListing(const QString& node, Node& state);
+    void finish(Node& state, const QString& upid, bool ok, const QString& exitStatus);
+    void pollFailed(Node& state, const QString& upid);
+    void endRound(const QString& node);
+
+    Fetch fetch;
+    std::map<QString, Node> nodes;
+    quint64 generation = 0;   // Bumped by clear(); replies of an older session are ignored
+    quint64 polls = 0;
+};
+
+#endif // TASKTRACKER_H
@@ -0,0 +1,81 @@
+#include "Tracing.h"
+#include <QString>
+#include <QThread>
+#include <chrono>
+
+Q_LOGGING_CATEGORY(lcModel, "proxmox.model", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcModelPaint, "proxmox.model.paint", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcNetwork, "proxmox.network", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcPerf, "proxmox.perf", QtWarningMsg)
+
+static qint64 steadyNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TraceRing& TraceRing::instance()
+{
+    static TraceRing ring;
+    return ring;
+}
+
+TraceRing::TraceRing() = default;
+
+void TraceRing::record(const char *name, qint64 arg1, qint64 arg2) noexcept
+{
+    if (!isEnabled()) return;
+
+    quint64 index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[index & (Capacity - 1)];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestampNs.store(steadyNowNs(), std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.arg1.store(arg1, std::memory_order_relaxed);
+    slot.arg2.store(arg2, std::memory_order_relaxed);
+    slot.threadId.store(reinterpret_cast<quintptr>(QThread::currentThreadId()), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+QStringList TraceRing::dump(int maxEvents) const
+{
+    QStringList lines;
+    quint64 end = head.load(std::memory_order_acquire);
+    quint64 count = qMin<quint64>(end, static_cast<quint64>(qBound(0, maxEvents, Capacity)));
+    quint64 skipped = 0;
+
+    qint64 firstTimestamp = -1;
+    for (quint64 index = end - count; index < end; ++index) {
+        const Slot& slot = ring[index & (Capacity - 1)];
+
+        // Seqlock read: accept the slot only if it holds this index and was not rewritten meanwhile
+        quint64 before = slot.sequence.load(std::memory_order_acquire);
+        qint64 timestamp = slot.timestampNs.load(std::memory_order_relaxed);
+        const char *name = slot.name.load(std::memory_order_relaxed);
+        qint64 arg1 = slot.arg1.load(std::memory_order_relaxed);
+        qint64 arg2 = slot.arg2.load(std::memory_order_relaxed);
+        quintptr threadId = slot.threadId.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        quint64 after = slot.sequence.load(std::memory_order_relaxed);
+
+        if (before != after || before != 2 * index + 2 || !name) {
+            skipped++;
+            continue;
+        }
+
+        if (firstTimestamp < 0) firstTimestamp = timestamp;
+        lines.append(QString("+%1 us [thread %2] %3 (%4, %5)")
+                         .arg((timestamp - firstTimestamp) / 1000)
+                         .arg(QString::number(static_cast<qulonglong>(threadId), 16))
+                         .arg(QString::fromLatin1(name))
+                         .arg(arg1)
+                         .arg(arg2));
+    }
+
+    if (skipped > 0) {
+        lines.append(QString("(%1 events skipped while being overwritten)").arg(skipped));
+    }
+    return lines;
+}
@@ -0,0 +1,71 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QLoggingCategory>
+#include <QStringList>
+#include <QtGlobal>
+#include <atomic>
+
+// --- LOGGING CATEGORIES ---
+// Enable at runtime with QT_LOGGING_RULES, e.g. "proxmox.model.debug=true".
+Q_DECLARE_LOGGING_CATEGORY(lcModel)      // Model structure changes (folders, moves)
+Q_DECLARE_LOGGING_CATEGORY(lcModelPaint) // Per-call tracing from data()/rowCount(); hot
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)    // Request engine activity
+Q_DECLARE_LOGGING_CATEGORY(lcPerf)       // Per-refresh timings, pool/coalescing counters, memory use
+
+// --- HOT-PATH TRACING ---
+// Anything called per painted cell must use these macros. They compile to nothing in
+// release builds (QT_NO_DEBUG) unless the project is built with CONFIG+=trace, so a
+// repaint never formats a log string or even checks a category.
+#if !defined(QT_NO_DEBUG) || defined(PROXMOX_TRACE)
+#  define PROXMOX_TRACE_ENABLED 1
+#  define pveTraceHot(category) qCDebug(category)
+#  define PVE_TRACE_EVENT(name, arg1, arg2) TraceRing::instance().record((name), (arg1), (arg2))
+#else
+#  define PROXMOX_TRACE_ENABLED 0
+#  define pveTraceHot(category) while (false) QMessageLogger().noDebug()
+#  define PVE_TRACE_EVENT(name, arg1, arg2) do { } while (false)
+#endif
+
+// --- TraceRing ---
+// Fixed-size, lock-free ring of trace events. record() only stores a static name
+// and two integers (no formatting, no allocation, wait-free); the text is built
+// when the ring is dumped. Writers claim slots with one fetch_add and publish them
+// with a per-slot sequence number, so dump() can skip slots being overwritten.
+class TraceRing
+{
+public:
+    static constexpr int Capacity = 4096; // Must be a power of two
+
+    static TraceRing& instance();
+
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // 'name' must point to a string literal (it is stored, not copied).
+    void record(const char *name, qint64 arg1 = 0, qint64 arg2 = 0) noexcept;
+
+    // Formats up to maxEvents most recent events, oldest first.
+    QStringList dump(int maxEvents = Capacity) const;
+
+    quint64 totalRecorded() const { return head.load(std::memory_order_relaxed); }
+
+private:
+    TraceRing();
+
+    struct Slot
+    {
+        std::atomic<quint64> sequence{0}; // 2*index+1 while writing, 2*index+2 once published
+        std::atomic<qint64> timestampNs{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<qint64> arg1{0};
+        std::atomic<qint64> arg2{0};
+        std::atomic<quintptr> threadId{0};
+    };
+
+    Slot ring[Capacity];
+    std::atomic<quint64> head{0};
+    std::atomic<bool> enabled{true};
+};
+
+#endif // TRACING_H
@@ -0,0 +1,119 @@
+#include "TreeItemPool.h"
+#include "VmModel.h" // For the full TreeItem definition
+#include <new>
+
+// --- CONSTANTS ---
+const int SLAB_ITEMS = 512; // Items per slab (~36 KB per slab on 64-bit)
+
+// Storage for one TreeItem. 'storage' must stay the first member so a TreeItem*
+// can be converted back to its Slot*.
+struct TreeItemPool::Slot
+{
+    alignas(TreeItem) unsigned char storage[sizeof(TreeItem)];
+    Slot *nextFree;
+    bool live;
+
+    TreeItem *item() { return reinterpret_cast<TreeItem*>(storage); }
+    static Slot *fromItem(TreeItem *item) { return reinterpret_cast<Slot*>(item); }
+};
+
+TreeItemPool::TreeItemPool() = default;
+
+TreeItemPool::~TreeItemPool()
+{
+    releaseAll();
+    for (Slot *slab : slabs) {
+        delete[] slab;
+    }
+}
+
+// --- SLOT MANAGEMENT ---
+
+TreeItemPool::Slot *TreeItemPool::allocateSlot()
+{
+    if (!freeList) {
+        Slot *slab = new Slot[SLAB_ITEMS];
+        slabs.push_back(slab);
+        // Thread the new slots in address order so consecutive allocations are adjacent
+        for (int i = SLAB_ITEMS - 1; i >= 0; --i) {
+            slab[i].live = false;
+            slab[i].nextFree = freeList;
+            freeList = &slab[i];
+        }
+        freeSlots += SLAB_ITEMS;
+    }
+
+    Slot *slot = freeList;
+    freeList = slot->nextFree;
+    freeSlots--;
+
+    slot->live = true;
+    liveItems++;
+    itemsCreated++;
+    if (liveItems > peakLiveItems) peakLiveItems = liveItems;
+    return slot;
+}
+
+void TreeItemPool::freeSlot(Slot *slot)
+{
+    slot->item()->~TreeItem();
+    slot->live = false;
+    slot->nextFree = freeList;
+    freeList = slot;
+    freeSlots++;
+    liveItems--;
+}
+
+// --- PUBLIC API ---
+
+TreeItem *TreeItemPool::createFolder(const QString& name, TreeItem *parentItem)
+{
+    Slot *slot = allocateSlot();
+    return new (slot->storage) TreeItem(name, true, parentItem);
+}
+
+TreeItem *TreeItemPool::createVm(int vmid, int inventoryRow, TreeItem *parentItem)
+{
+    Slot *slot = allocateSlot();
+    return new (slot->storage) TreeItem(vmid, inventoryRow, parentItem);
+}
+
+void TreeItemPool::destroy(TreeItem *item)
+{
+    if (!item) return;
+    for (TreeItem *child : item->children) {
+        destroy(child);
+    }
+    freeSlot(Slot::fromItem(item));
+}
+
+void TreeItemPool::releaseAll()
+{
+    // Destruct live items, then rebuild the free list in slab/address order
+    freeList = nullptr;
+    for (auto slabIt = slabs.rbegin(); slabIt != slabs.rend(); ++slabIt) {
+        Slot *slab = *slabIt;
+        for (int i = SLAB_ITEMS - 1; i >= 0; --i) {
+            if (slab[i].live) {
+                slab[i].item()->~TreeItem();
+                slab[i].live = false;
+            }
+            slab[i].nextFree = freeList;
+            freeList = &slab[i];
+        }
+    }
+    liveItems = 0;
+    freeSlots = static_cast<int>(slabs.size()) * SLAB_ITEMS;
+}
+
+TreeItemPool::Stats TreeItemPool::stats() const
+{
+    Stats s;
+    s.slabCount = static_cast<int>(slabs.size());
+    s.slabBytes = static_cast<qint64>(slabs.size()) * SLAB_ITEMS * sizeof(Slot);
+    s.liveItems = liveItems;
+    s.peakLiveItems = peakLiveItems;
+    s.freeSlots = freeSlots;
+    s.itemsCreated = itemsCreated;
+    return s;
+}
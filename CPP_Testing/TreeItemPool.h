@@ -0,0 +1,58 @@
+#ifndef TREEITEMPOOL_H
+#define TREEITEMPOOL_H
+
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+struct TreeItem;
+
+// --- TreeItemPool ---
+// Slab allocator for the TreeItem nodes of one VmModel. Items are placement-new'ed
+// into fixed-size slabs, so a tree built in one pass sits contiguously in memory
+// (siblings end up next to each other), freed slots are recycled through a free
+// list, and releaseAll() drops a whole tree without walking it node by node.
+class TreeItemPool
+{
+public:
+    struct Stats
+    {
+        qint64 slabBytes = 0;    // Memory reserved for item storage
+        int slabCount = 0;
+        int liveItems = 0;       // Items currently constructed
+        int peakLiveItems = 0;
+        int freeSlots = 0;       // Slots available without allocating a new slab
+        qint64 itemsCreated = 0; // Total constructions since the pool was created
+    };
+
+    TreeItemPool();
+    ~TreeItemPool();
+    TreeItemPool(const TreeItemPool&) = delete;
+    TreeItemPool& operator=(const TreeItemPool&) = delete;
+
+    TreeItem *createFolder(const QString& name, TreeItem *parentItem = nullptr);
+    TreeItem *createVm(int vmid, int inventoryRow, TreeItem *parentItem = nullptr);
+
+    // Destroys an item and its whole subtree; the slots go back to the free list.
+    void destroy(TreeItem *item);
+
+    // Destroys every live item at once. Slabs are kept for the next build.
+    void releaseAll();
+
+    Stats stats() const;
+
+private:
+    struct Slot;
+
+    Slot *allocateSlot();
+    void freeSlot(Slot *slot);
+
+    std::vector<Slot*> slabs;   // Each entry is an array of SLAB_ITEMS slots
+    Slot *freeList = nullptr;
+    int liveItems = 0;
+    int peakLiveItems = 0;
+    int freeSlots = 0;
+    qint64 itemsCreated = 0;
+};
+
+#endif // TREEITEMPOOL_H
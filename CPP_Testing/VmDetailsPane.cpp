@@ -0,0 +1,167 @@
+#include "VmDetailsPane.h"
+#include <QComboBox>
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <cmath>
+#include <limits>
+
+// --- CONSTANTS ---
+const QString VmDetailsPane::LiveTimeframe = "live";
+const int LIVE_WINDOW_SECS = 4 * 60 * 60;     // Matches the MetricsHistory retention
+const QColor PRIMARY_COLOR(31, 119, 180);
+const QColor SECONDARY_COLOR(255, 127, 14);
+
+VmDetailsPane::VmDetailsPane(const MetricsHistory& history, QWidget *parent)
+    : QWidget(parent), history(history)
+{
+    titleLabel = new QLabel("No VM selected");
+    statusLabel = new QLabel();
+    timeframeCombo = new QComboBox();
+    timeframeCombo->addItem("Live (last 4 hours)", LiveTimeframe);
+    timeframeCombo->addItem("Hour", "hour");
+    timeframeCombo->addItem("Day", "day");
+    timeframeCombo->addItem("Week", "week");
+    timeframeCombo->addItem("Month", "month");
+    timeframeCombo->addItem("Year", "year");
+    timeframeCombo->setCurrentIndex(1);
+    connect(timeframeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int) { reload(); });
+
+    cpuChart = new MetricChart("CPU", MetricChart::Unit::Percent);
+    memoryChart = new MetricChart("Memory", MetricChart::Unit::Bytes);
+    networkChart = new MetricChart("Network", MetricChart::Unit::BytesPerSecond);
+    diskChart = new MetricChart("Disk IO", MetricChart::Unit::BytesPerSecond);
+
+    QHBoxLayout *headerLayout = new QHBoxLayout();
+    headerLayout->addWidget(titleLabel, 1);
+    headerLayout->addWidget(statusLabel);
+    headerLayout->addWidget(timeframeCombo);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(headerLayout);
+    layout->addWidget(cpuChart, 1);
+    layout->addWidget(memoryChart, 1);
+    layout->addWidget(networkChart, 1);
+    layout->addWidget(diskChart, 1);
+
+    clearVm();
+}
+
+QString VmDetailsPane::timeframe() const
+{
+    return timeframeCombo->currentData().toString();
+}
+
+void VmDetailsPane::showVm(const Vm& selected)
+{
+    const bool sameVm = hasVm && selected.vmid == vm.vmid;
+    vm = selected;
+    hasVm = true;
+    titleLabel->setText(QString("%1 (VMID %2) on %3").arg(vm.name).arg(vm.vmid).arg(vm.node));
+    if (!sameVm) reload();
+}
+
+void VmDetailsPane::clearVm()
+{
+    hasVm = false;
+    titleLabel->setText("No VM selected");
+    statusLabel->clear();
+    showMessage("Select a VM to see its usage");
+}
+
+void VmDetailsPane::reload()
+{
+    if (!hasVm) return;
+    statusLabel->clear();
+    if (timeframe() == LiveTimeframe) {
+        refreshLive();
+        return;
+    }
+    showMessage("Loading...");
+    emit rrdDataRequested(vm.vmid, vm.node, vm.type, timeframe());
+}
+
+void VmDetailsPane::refreshLive()
+{
+    if (!hasVm || timeframe() != LiveTimeframe) return;
+    const RrdSeries series = liveSeries();
+    if (series.size() < 2) {
+        showMessage("Collecting samples (one per poll)...");
+        return;
+    }
+    showSeries(series);
+}
+
+void VmDetailsPane::setRrdData(int vmid, const QString& dataTimeframe, const RrdSeries& series, const QString& error)
+{
+    if (!hasVm || vmid != vm.vmid || dataTimeframe != timeframe()) return;   // Selection moved on
+    if (!error.isEmpty()) {
+        // Keep whatever is shown (possibly the cached series) and say why it is not current
+        statusLabel->setText(QString("Update failed: %1").arg(error));
+        if (!showingData) showMessage("No data");
+        return;
+    }
+    statusLabel->clear();
+    showSeries(series);
+}
+
+void VmDetailsPane::showMessage(const QString& message)
+{
+    showingData = false;
+    for (MetricChart *chart : {cpuChart, memoryChart, networkChart, diskChart}) {
+        chart->setLines({});
+        chart->setMessage(message);
+    }
+}
+
+void VmDetailsPane::showSeries(const RrdSeries& series)
+{
+    auto line = [&series](const QString& label, const QColor& color, const QVector<double>& values, double scale = 1.0) {
+        MetricChart::Line result{label, color, {}};
+        result.points.reserve(series.size());
+        for (int i = 0; i < series.size(); ++i) {
+            result.points.append(QPointF(series.time[i], values[i] * scale));
+        }
+        return result;
+    };
+
+    showingData = true;
+    cpuChart->setLines({line("used", PRIMARY_COLOR, series.cpu, 100.0)});
+    memoryChart->setLines({line("used", PRIMARY_COLOR, series.mem), line("total", SECONDARY_COLOR, series.maxmem)});
+    networkChart->setLines({line("in", PRIMARY_COLOR, series.netin), line("out", SECONDARY_COLOR, series.netout)});
+    diskChart->setLines({line("read", PRIMARY_COLOR, series.diskread), line("write", SECONDARY_COLOR, series.diskwrite)});
+}
+
+// The local history in RRD form. /cluster/resources reports network and disk IO as
+// running totals, so those become rates between consecutive polls.
+RrdSeries VmDetailsPane::liveSeries() const
+{
+    const qint64 to = QDateTime::currentSecsSinceEpoch();
+    const qint64 from = to - LIVE_WINDOW_SECS;
+    QVector<MetricsHistory::Sample> samples[MetricsHistory::MetricCount];
+    for (int metric = 0; metric < MetricsHistory::MetricCount; ++metric) {
+        samples[metric] = history.range(vm.vmid, static_cast<MetricsHistory::Metric>(metric), from, to);
+    }
+
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    const QVector<MetricsHistory::Sample>& times = samples[MetricsHistory::Cpu];
+    auto value = [&](MetricsHistory::Metric metric, int i) {
+        // Every metric of a guest is recorded at the same instants
+        return i < samples[metric].size() ? samples[metric][i].value : missing;
+    };
+    auto rate = [&](MetricsHistory::Metric metric, int i) {
+        if (i == 0) return missing;
+        const double delta = value(metric, i) - value(metric, i - 1);
+        const double seconds = times[i].time - times[i - 1].time;
+        return (delta >= 0.0 && seconds > 0.0) ? delta / seconds : missing;   // Negative: counter reset (reboot)
+    };
+
+    RrdSeries series;
+    for (int i = 0; i < times.size(); ++i) {
+        series.append(times[i].time, value(MetricsHistory::Cpu, i), value(MetricsHistory::Mem, i),
+                      value(MetricsHistory::MaxMem, i), rate(MetricsHistory::NetIn, i), rate(MetricsHistory::NetOut, i),
+                      rate(MetricsHistory::DiskRead, i), rate(MetricsHistory::DiskWrite, i));
+    }
+    return series;
+}
@@ -0,0 +1,61 @@
+#ifndef VMDETAILSPANE_H
+#define VMDETAILSPANE_H
+
+#include <QString>
+#include <QWidget>
+#include "MetricChart.h"
+#include "MetricsHistory.h"
+#include "ProxmoxApiManager.h" // For struct Vm
+#include "RrdFetcher.h"
+
+class QComboBox;
+class QLabel;
+
+// --- VmDetailsPane ---
+// Usage charts (CPU, memory, network, disk IO) of the guest selected in the tree.
+// The "live" timeframe is drawn from the client's own MetricsHistory and needs no
+// request; the others are the server's RRD statistics, asked for through
+// rrdDataRequested whenever the guest or timeframe changes and delivered back to
+// setRrdData (RrdFetcher caches them, so re-selecting a guest is instant).
+class VmDetailsPane : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit VmDetailsPane(const MetricsHistory& history, QWidget *parent = nullptr);
+
+    void showVm(const Vm& vm);
+    void clearVm();                // No single guest selected
+    QString timeframe() const;     // "live" or an RRD timeframe (hour, day, ...)
+
+    static const QString LiveTimeframe;
+
+public slots:
+    void setRrdData(int vmid, const QString& timeframe, const RrdSeries& series, const QString& error);
+    // A new poll was recorded in the history; redraws the live charts
+    void refreshLive();
+
+signals:
+    void rrdDataRequested(int vmid, const QString& node, const QString& type, const QString& timeframe);
+
+private:
+    void reload();
+    void showSeries(const RrdSeries& series);
+    void showMessage(const QString& message);
+    RrdSeries liveSeries() const;
+
+    const MetricsHistory& history;
+    Vm vm;
+    bool hasVm = false;
+    bool showingData = false;      // Charts hold a series (not a message)
+
+    QLabel *titleLabel = nullptr;
+    QLabel *statusLabel = nullptr;
+    QComboBox *timeframeCombo = nullptr;
+    MetricChart *cpuChart = nullptr;
+    MetricChart *memoryChart = nullptr;
+    MetricChart *networkChart = nullptr;
+    MetricChart *diskChart = nullptr;
+};
+
+#endif // VMDETAILSPANE_H
@@ -0,0 +1,303 @@
+#include "VmInventory.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <type_traits>
+#include "ProxmoxApiManager.h" // For Vm struct
+
+// --- RowSet ---
+
+RowSet::RowSet(int rows, bool value)
+    : words((rows + 63) / 64, value ? ~quint64(0) : 0), rows(rows)
+{
+    // Keep the bits past the last row clear so count() and forEach() stay exact
+    if (value && (rows & 63)) words.back() = (quint64(1) << (rows & 63)) - 1;
+}
+
+void RowSet::set(int row, bool on)
+{
+    quint64 bit = quint64(1) << (row & 63);
+    if (on) {
+        words[row >> 6] |= bit;
+    } else {
+        words[row >> 6] &= ~bit;
+    }
+}
+
+int RowSet::count() const
+{
+    int total = 0;
+    for (quint64 word : words) total += qPopulationCount(word);
+    return total;
+}
+
+RowSet& RowSet::operator&=(const RowSet& other)
+{
+    for (size_t w = 0; w < words.size() && w < other.words.size(); ++w) words[w] &= other.words[w];
+    for (size_t w = other.words.size(); w < words.size(); ++w) words[w] = 0;
+    return *this;
+}
+
+RowSet& RowSet::operator|=(const RowSet& other)
+{
+    for (size_t w = 0; w < words.size() && w < other.words.size(); ++w) words[w] |= other.words[w];
+    return *this;
+}
+
+// --- ROWS ---
+
+template<class Self, class F>
+void VmInventory::forEachColumn(Self& self, F visit)
+{
+    visit(self.vmid);
+    visit(self.type);
+    visit(self.status);
+    visit(self.nodeId);
+    visit(self.folderId);
+    visit(self.poolId);
+    visit(self.tagsId);
+    visit(self.hastateId);
+    visit(self.name);
+    visit(self.cpu);
+    visit(self.maxcpu);
+    visit(self.mem);
+    visit(self.maxmem);
+    visit(self.disk);
+    visit(self.maxdisk);
+    visit(self.netin);
+    visit(self.netout);
+    visit(self.diskread);
+    visit(self.diskwrite);
+    visit(self.uptime);
+    visit(self.isTemplate);
+}
+
+int VmInventory::upsert(const Vm& vm, bool *changed)
+{
+    int row = rowOf(vm.vmid);
+    bool differs = row < 0;
+    if (row < 0) {
+        row = size();
+        rowIndex.insert(vm.vmid, row);
+        forEachColumn(*this, [](auto& column) { column.emplace_back(); });
+    }
+
+    // Only writes (and reports) the columns whose value actually changed
+    auto store = [row, &differs](auto& column, auto value) {
+        if (!(column[row] == value)) {
+            column[row] = std::move(value);
+            differs = true;
+        }
+    };
+    store(vmid, static_cast<qint32>(vm.vmid));
+    store(type, vmTypeFromString(vm.type));
+    store(status, vmStatusFromString(vm.status));
+    store(nodeId, strings.intern(vm.node));
+    store(folderId, strings.intern(vm.folder));
+    store(poolId, strings.intern(vm.pool));
+    store(tagsId, strings.intern(vm.tags));
+    store(hastateId, strings.intern(vm.hastate));
+    store(name, vm.name);
+    store(cpu, static_cast<float>(vm.cpu));
+    store(maxcpu, static_cast<quint16>(qBound(0, vm.maxcpu, 0xFFFF)));
+    store(mem, vm.mem);
+    store(maxmem, vm.maxmem);
+    store(disk, vm.disk);
+    store(maxdisk, vm.maxdisk);
+    store(netin, vm.netin);
+    store(netout, vm.netout);
+    store(diskread, vm.diskread);
+    store(diskwrite, vm.diskwrite);
+    store(uptime, static_cast<quint32>(qBound<qint64>(0, vm.uptime, 0xFFFFFFFF)));
+    store(isTemplate, static_cast<quint8>(vm.isTemplate ? 1 : 0));
+
+    if (changed) *changed = differs;
+    return row;
+}
+
+int VmInventory::remove(int vmidValue)
+{
+    int row = rowOf(vmidValue);
+    if (row < 0) return 0;
+    rowIndex.remove(vmidValue);
+
+    const int last = size() - 1;
+    forEachColumn(*this, [row, last](auto& column) {
+        if (row != last) column[row] = std::move(column[last]);
+        column.pop_back();
+    });
+    if (row == last) return 0;
+
+    int moved = vmid[row];
+    rowIndex.insert(moved, row);
+    return moved;
+}
+
+void VmInventory::clear()
+{
+    rowIndex.clear();
+    forEachColumn(*this, [](auto& column) { column.clear(); });
+}
+
+Vm VmInventory::toVm(int row) const
+{
+    Vm vm;
+    vm.vmid = vmid[row];
+    vm.type = vmTypeText(type[row]);
+    vm.status = vmStatusText(status[row]);
+    vm.node = nodeAt(row);
+    vm.name = name[row];
+    vm.folder = folderAt(row);
+    vm.pool = poolAt(row);
+    vm.tags = tagsAt(row);
+    vm.hastate = hastateAt(row);
+    vm.cpu = cpu[row];
+    vm.maxcpu = maxcpu[row];
+    vm.mem = mem[row];
+    vm.maxmem = maxmem[row];
+    vm.disk = disk[row];
+    vm.maxdisk = maxdisk[row];
+    vm.netin = netin[row];
+    vm.netout = netout[row];
+    vm.diskread = diskread[row];
+    vm.diskwrite = diskwrite[row];
+    vm.uptime = uptime[row];
+    vm.isTemplate = isTemplate[row] != 0;
+    return vm;
+}
+
+// --- SCANS ---
+
+// Evaluates 'match' for 64 rows at a time into one word. 'match' reads plain column
+// arrays, so the inner loop is branch-free and the compiler can vectorize it.
+template<class Pred>
+RowSet VmInventory::scan(Pred match) const
+{
+    const int rows = size();
+    RowSet result(rows);
+    std::vector<quint64>& words = result.data();
+    for (int base = 0, w = 0; base < rows; base += 64, ++w) {
+        const int n = qMin(64, rows - base);
+        quint64 bits = 0;
+        for (int j = 0; j < n; ++j) {
+            bits |= quint64(match(base + j)) << j;
+        }
+        words[w] = bits;
+    }
+    return result;
+}
+
+RowSet VmInventory::whereStatus(VmStatus value) const
+{
+    const VmStatus *column = status.data();
+    return scan([column, value](int row) { return column[row] == value; });
+}
+
+RowSet VmInventory::whereType(VmType value) const
+{
+    const VmType *column = type.data();
+    return scan([column, value](int row) { return column[row] == value; });
+}
+
+RowSet VmInventory::whereNode(const QString& node) const
+{
+    // Compare ids, not strings; a name that was never interned matches nothing
+    quint32 id = strings.find(node);
+    if (id == StringTable::NoId) return RowSet(size());
+
+    const quint32 *column = nodeId.data();
+    return scan([column, id](int row) { return column[row] == id; });
+}
+
+RowSet VmInventory::whereCpuAbove(double fraction) const
+{
+    const float *column = cpu.data();
+    const float limit = static_cast<float>(fraction);
+    return scan([column, limit](int row) { return column[row] > limit; });
+}
+
+RowSet VmInventory::whereMemAbove(double fraction) const
+{
+    const qint64 *used = mem.data();
+    const qint64 *total = maxmem.data();
+    return scan([used, total, fraction](int row) {
+        return total[row] > 0 && static_cast<double>(used[row]) > fraction * static_cast<double>(total[row]);
+    });
+}
+
+qint64 VmInventory::bytes() const
+{
+    qint64 total = 0;
+    forEachColumn(*this, [&total](const auto& column) {
+        total += static_cast<qint64>(column.capacity()) * sizeof(typename std::decay_t<decltype(column)>::value_type);
+    });
+    for (const QString& text : name) {
+        total += static_cast<qint64>(text.capacity()) * sizeof(QChar);
+    }
+    total += static_cast<qint64>(rowIndex.size()) * (2 * sizeof(int) + 2 * sizeof(void*));
+    return total + strings.bytes();
+}
+
+// --- BENCHMARK ---
+
+QString VmInventory::benchmark(int rows)
+{
+    const int NODES = 32;
+    const int ITERATIONS = 20;
+    const qint64 GIB = qint64(1) << 30;
+
+    // Deterministic pseudo-random cluster: mixed types, ~70% running, varied memory use
+    QVector<Vm> records;
+    records.reserve(rows);
+    quint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int i = 0; i < rows; ++i) {
+        Vm vm;
+        vm.vmid = 100 + i;
+        vm.type = (next() % 4 == 0) ? QStringLiteral("lxc") : QStringLiteral("qemu");
+        vm.status = (next() % 10 < 7) ? QStringLiteral("running") : QStringLiteral("stopped");
+        vm.node = QString("pve-node-%1").arg(next() % NODES, 2, 10, QChar('0'));
+        vm.name = QString("guest-%1").arg(i);
+        vm.maxmem = (1 + next() % 16) * GIB;
+        vm.mem = static_cast<qint64>(vm.maxmem * ((next() % 1000) / 1000.0));
+        vm.cpu = (next() % 1000) / 1000.0;
+        records.append(vm);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    VmInventory inventory;
+    for (const Vm& vm : records) inventory.upsert(vm);
+    qint64 loadUs = timer.nsecsElapsed() / 1000;
+
+    const QString node = QStringLiteral("pve-node-07");
+    int columnarMatches = 0;
+    timer.restart();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        RowSet hits = inventory.whereStatus(VmStatus::Running);
+        hits &= inventory.whereType(VmType::Qemu);
+        hits &= inventory.whereNode(node);
+        hits &= inventory.whereMemAbove(0.8);
+        columnarMatches = hits.count();
+    }
+    qint64 columnarNs = timer.nsecsElapsed() / ITERATIONS;
+
+    int recordMatches = 0;
+    timer.restart();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        int matches = 0;
+        for (const Vm& vm : records) {
+            if (vm.status == QLatin1String("running") && vm.type == QLatin1String("qemu") && vm.node == node
+                && vm.maxmem > 0 && vm.mem > 0.8 * vm.maxmem) {
+                matches++;
+            }
+        }
+        recordMatches = matches;
+    }
+    qint64 recordNs = timer.nsecsElapsed() / ITERATIONS;
+
+    return QString("Inventory benchmark, %1 rows: load %2 ms, %3 bytes/row; query (running qemu on %4, mem > 80%) "
+                   "columnar %5 us vs QVector<Vm> %6 us, %7/%8 matches")
+        .arg(rows).arg(loadUs / 1000).arg(rows > 0 ? inventory.bytes() / rows : 0).arg(node)
+        .arg(columnarNs / 1000.0, 0, 'f', 1).arg(recordNs / 1000.0, 0, 'f', 1)
+        .arg(columnarMatches).arg(recordMatches);
+}
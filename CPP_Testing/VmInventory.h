@@ -0,0 +1,144 @@
+#ifndef VMINVENTORY_H
+#define VMINVENTORY_H
+
+#include <QHash>
+#include <QString>
+#include <QtAlgorithms>
+#include <QtGlobal>
+#include <vector>
+#include "VmRecord.h"
+
+struct Vm;
+
+// --- RowSet ---
+// Bitset over inventory rows: the result of a scan, combinable with & and |.
+class RowSet
+{
+public:
+    explicit RowSet(int rows = 0, bool value = false);
+
+    int size() const { return rows; }
+    bool test(int row) const { return (words[row >> 6] >> (row & 63)) & 1; }
+    void set(int row, bool on = true);
+    int count() const;
+
+    RowSet& operator&=(const RowSet& other);
+    RowSet& operator|=(const RowSet& other);
+
+    // Calls visit(row) for every set row, in ascending order
+    template<class F> void forEach(F visit) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            quint64 bits = words[w];
+            while (bits) {
+                visit(static_cast<int>(w * 64 + qCountTrailingZeroBits(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Direct word access for scans (bits past size() must stay clear)
+    std::vector<quint64>& data() { return words; }
+
+private:
+    std::vector<quint64> words;
+    int rows = 0;
+};
+
+// --- VmInventory ---
+// Structure-of-arrays store of every known VM: one contiguous column per field,
+// indexed by row. It is the model's single copy of VM data; TreeItems only hold a
+// row number. Scans (where*) walk one or two plain columns and produce RowSets, so
+// a query like "running qemu guests on node X above 80% memory" touches a few
+// bytes per VM instead of whole records. Rows are not stable across remove(): the
+// last row moves into the hole (see remove()). Not thread-safe (the model's thread).
+class VmInventory
+{
+public:
+    int size() const { return static_cast<int>(vmid.size()); }
+    int rowOf(int vmidValue) const { return rowIndex.value(vmidValue, -1); }
+
+    // Inserts or overwrites the row for vm.vmid; 'changed' reports whether any column differs
+    int upsert(const Vm& vm, bool *changed = nullptr);
+    // Removes a VM by swapping the last row into its place. Returns the vmid now at
+    // the freed row (whose row number changed), or 0 if nothing moved.
+    int remove(int vmidValue);
+    void clear();   // Drops every row; interned strings are kept
+
+    Vm toVm(int row) const;
+
+    // --- Column access ---
+    qint32 vmidAt(int row) const { return vmid[row]; }
+    VmType typeAt(int row) const { return type[row]; }
+    VmStatus statusAt(int row) const { return status[row]; }
+    const QString& nameAt(int row) const { return name[row]; }
+    const QString& nodeAt(int row) const { return strings.text(nodeId[row]); }
+    const QString& folderAt(int row) const { return strings.text(folderId[row]); }
+    const QString& poolAt(int row) const { return strings.text(poolId[row]); }
+    const QString& tagsAt(int row) const { return strings.text(tagsId[row]); }
+    const QString& hastateAt(int row) const { return strings.text(hastateId[row]); }
+    float cpuAt(int row) const { return cpu[row]; }
+    int maxcpuAt(int row) const { return maxcpu[row]; }
+    qint64 memAt(int row) const { return mem[row]; }
+    qint64 maxmemAt(int row) const { return maxmem[row]; }
+    qint64 diskAt(int row) const { return disk[row]; }
+    qint64 maxdiskAt(int row) const { return maxdisk[row]; }
+    qint64 netinAt(int row) const { return netin[row]; }
+    qint64 netoutAt(int row) const { return netout[row]; }
+    qint64 diskreadAt(int row) const { return diskread[row]; }
+    qint64 diskwriteAt(int row) const { return diskwrite[row]; }
+    qint64 uptimeAt(int row) const { return uptime[row]; }
+    bool isTemplateAt(int row) const { return isTemplate[row] != 0; }
+
+    void setStatus(int row, VmStatus value) { status[row] = value; }
+    void setName(int row, const QString& value) { name[row] = value; }
+    void setFolder(int row, const QString& folder) { folderId[row] = strings.intern(folder); }
+
+    // --- Scans ---
+    RowSet all() const { return RowSet(size(), true); }
+    RowSet whereStatus(VmStatus value) const;
+    RowSet whereType(VmType value) const;
+    RowSet whereNode(const QString& node) const;
+    RowSet whereCpuAbove(double fraction) const;
+    RowSet whereMemAbove(double fraction) const;   // mem > fraction * maxmem (guests with maxmem 0 never match)
+
+    // Heap used by the columns, the vmid index and the string table (approximate)
+    qint64 bytes() const;
+
+    // Builds a synthetic inventory of 'rows' VMs and times a typical query against it,
+    // the column scans versus the same filter over a QVector<Vm>. Returns a summary line.
+    static QString benchmark(int rows);
+
+private:
+    template<class Pred> RowSet scan(Pred match) const;
+    // Calls visit(column) for every column vector, so the structural operations
+    // (remove, clear, bytes) cannot miss one when a column is added
+    template<class Self, class F> static void forEachColumn(Self& self, F visit);
+
+    StringTable strings;   // Node, folder, pool, tag and HA state strings; kept across clear()
+    QHash<int, int> rowIndex;   // vmid -> row
+
+    // --- Columns (all the same length) ---
+    std::vector<qint32> vmid;
+    std::vector<VmType> type;
+    std::vector<VmStatus> status;
+    std::vector<quint32> nodeId;
+    std::vector<quint32> folderId;
+    std::vector<quint32> poolId;
+    std::vector<quint32> tagsId;
+    std::vector<quint32> hastateId;
+    std::vector<QString> name;
+    std::vector<float> cpu;
+    std::vector<quint16> maxcpu;
+    std::vector<qint64> mem;
+    std::vector<qint64> maxmem;
+    std::vector<qint64> disk;
+    std::vector<qint64> maxdisk;
+    std::vector<qint64> netin;
+    std::vector<qint64> netout;
+    std::vector<qint64> diskread;
+    std::vector<qint64> diskwrite;
+    std::vector<quint32> uptime;     // Seconds (136 years fit)
+    std::vector<quint8> isTemplate;  // Not vector<bool>: the columns must stay plain arrays
+};
+
+#endif // VMINVENTORY_H
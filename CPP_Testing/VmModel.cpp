@@ -1,19 +1,24 @@
 #include "VmModel.h"
 #include <QDebug>
+#include "Tracing.h"
 #include <QIcon>
+#include <QColor>
+#include <QFont>
 #include <QMap> // Added for setVmList logic
-#include <algorithm> // For std::sort
-#include <functional> // For std::function in findVmItem
-
-// NOTE: Implementation of TreeItem::row() is still required in the .cpp file, but is not needed for the current fixes.
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include <algorithm> // For std::sort, std::is_sorted
+#include <functional> // For std::function in memoryStats
 
 // --- TreeItem Utility ---
 
-// Helper: Finds the row of a TreeItem within its parent's children list.
+// Helper: Row of a TreeItem within its parent's children list. VmModel::parent()
+// calls this constantly while painting, so it reads the cached index instead of scanning.
 int TreeItem::row() const
 {
     if (parent)
-        return parent->children.indexOf(const_cast<TreeItem*>(this));
+        return rowInParent;
     return 0; // Or -1 if the root item is not expected to call this
 }
 
@@ -27,39 +32,54 @@ TreeItem* VmModel::getItem(const QModelIndex &index) const
     return rootItem;
 }
 
-// Helper: Finds a VM item anywhere in the tree by its VMID
+// Helper: Finds a VM item anywhere in the tree by its VMID (O(1) via vmIndex)
 TreeItem *VmModel::findVmItem(int vmid) const
 {
-    // Simple recursive search (can be optimized but is fine for moderate lists)
-    std::function<TreeItem*(TreeItem*)> search = 
-        [&](TreeItem* parentItem) -> TreeItem* {
-        
-        for (TreeItem* child : parentItem->children) {
-            if (!child->isFolder) {
-                if (child->vmData.vmid == vmid) {
-                    return child;
-                }
-            } else {
-                // Recurse into folders
-                TreeItem* found = search(child);
-                if (found) return found;
-            }
-        }
-        return nullptr;
-    };
-    
-    return search(rootItem);
+    return vmIndex.value(vmid, nullptr);
 }
 
-// Helper: Finds a folder item directly under the root by name
+// Helper: Finds a folder item directly under the root by name, case-insensitively (O(1) via folderIndex)
 TreeItem *VmModel::findFolderItem(const QString& folderName) const
 {
-    for (TreeItem* item : rootItem->children) {
-        if (item->isFolder && item->name.toLower() == folderName.toLower()) {
-            return item;
+    return folderIndex.value(folderKey(folderName), nullptr);
+}
+
+// Helper: Key used for folderIndex (folder names compare case-insensitively)
+QString VmModel::folderKey(const QString& folderName)
+{
+    return folderName.trimmed().toCaseFolded();
+}
+
+// Adds an item (and anything below it) to the lookup indexes
+void VmModel::indexItem(TreeItem *item)
+{
+    if (item->isFolder) {
+        folderIndex.insert(folderKey(item->name), item);
+        for (TreeItem *child : item->children) {
+            indexItem(child);
+        }
+    } else {
+        vmIndex.insert(item->vmid, item);
+    }
+}
+
+// Removes an item (and anything below it) from the lookup indexes
+void VmModel::unindexItem(TreeItem *item)
+{
+    if (item->isFolder) {
+        if (folderIndex.value(folderKey(item->name)) == item)
+            folderIndex.remove(folderKey(item->name));
+        for (TreeItem *child : item->children) {
+            unindexItem(child);
+        }
+    } else if (vmIndex.value(item->vmid) == item) {
+        vmIndex.remove(item->vmid);
+        // The last inventory row moves into the freed one; repoint its item
+        int moved = vmStore.remove(item->vmid);
+        if (TreeItem *movedItem = vmIndex.value(moved, nullptr)) {
+            movedItem->inventoryRow = vmStore.rowOf(moved);
         }
     }
-    return nullptr;
 }
 
 
@@ -70,13 +90,13 @@ VmModel::VmModel(QObject *parent)
     : QAbstractItemModel(parent)
 {
     // The root item is hidden, representing the entire collection
-    rootItem = new TreeItem("Root", true); 
+    rootItem = itemPool.createFolder("Root"); 
 }
 
-// Destructor: Cleans up the tree structure
+// Destructor: Cleans up the tree structure (every item lives in itemPool)
 VmModel::~VmModel()
 {
-    delete rootItem;
+    itemPool.releaseAll();
 }
 
 // ----------------------------------------------------
@@ -86,7 +106,7 @@ VmModel::~VmModel()
 int VmModel::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return 4; // Name/Folder, VMID, Status, Type
+    return ColumnCount;
 }
 
 // CORRECT implementation of headerData
@@ -94,10 +114,22 @@ QVariant VmModel::headerData(int section, Qt::Orientation orientation, int role)
 {
     if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
         switch (section) {
-            case 0: return "Name / Folder";
-            case 1: return "VMID";
-            case 2: return "Status";
-            case 3: return "Type";
+            case NameColumn:      return "Name / Folder";
+            case VmidColumn:      return "VMID";
+            case StatusColumn:    return "Status";
+            case TypeColumn:      return "Type";
+            case CpuColumn:       return "CPU";
+            case MemoryColumn:    return "Memory";
+            case DiskColumn:      return "Disk";
+            case NetInColumn:     return "Net In";
+            case NetOutColumn:    return "Net Out";
+            case DiskReadColumn:  return "Disk Read";
+            case DiskWriteColumn: return "Disk Write";
+            case UptimeColumn:    return "Uptime";
+            case PoolColumn:      return "Pool";
+            case TagsColumn:      return "Tags";
+            case HaStateColumn:   return "HA";
+            case TemplateColumn:  return "Template";
         }
     }
     return QVariant();
@@ -137,19 +169,50 @@ QModelIndex VmModel::parent(const QModelIndex &child) const
         return QModelIndex();
 
     // Correctly finding the parent's row number for the parent index
-    return createIndex(parentItem->row(), 0, parentItem->parent);
+    return createIndex(parentItem->row(), 0, parentItem);
 }
 
 int VmModel::rowCount(const QModelIndex &parent) const
 {
     TreeItem *parentItem = getItem(parent);
     
-    // DEBUG: Check rowCount for the requested parent item
-    qDebug() << "rowCount called for parent:" << parentItem->name << "Children count:" << parentItem->children.count();
+    // Hot path: compiled out of release builds (see Tracing.h)
+    PVE_TRACE_EVENT("VmModel::rowCount", parentItem->children.count(), 0);
+    pveTraceHot(lcModelPaint) << "rowCount called for parent:" << parentItem->name << "Children count:" << parentItem->children.count();
     
     return parentItem->children.count();
 }
 
+// Status a power action leads to, and the label shown while it is in progress
+static VmStatus targetStatusFor(const QString& action)
+{
+    return (action == "start" || action == "reboot" || action == "resume") ? VmStatus::Running : VmStatus::Stopped;
+}
+
+static QString transitionLabel(const QString& action)
+{
+    if (action == "start") return QString::fromUtf8("starting\xE2\x80\xA6");
+    if (action == "stop") return QString::fromUtf8("stopping\xE2\x80\xA6");
+    if (action == "shutdown") return QString::fromUtf8("shutting down\xE2\x80\xA6");
+    if (action == "reboot") return QString::fromUtf8("rebooting\xE2\x80\xA6");
+    return action + QString::fromUtf8("\xE2\x80\xA6");
+}
+
+// Cell text for uptimes: "3d 04:12:05"
+static QString formatUptime(qint64 seconds)
+{
+    const int days = static_cast<int>(seconds / 86400);
+    const QString clock = QString("%1:%2:%3").arg(static_cast<int>(seconds / 3600 % 24), 2, 10, QChar('0'))
+                                             .arg(static_cast<int>(seconds / 60 % 60), 2, 10, QChar('0'))
+                                             .arg(static_cast<int>(seconds % 60), 2, 10, QChar('0'));
+    return days > 0 ? QString("%1d %2").arg(days).arg(clock) : clock;
+}
+
+static bool isNumericColumn(int column)
+{
+    return column >= VmModel::CpuColumn && column <= VmModel::UptimeColumn;
+}
+
 // CORRECT implementation of data (using 'int' for role)
 QVariant VmModel::data(const QModelIndex &index, int role) const
 {
@@ -163,109 +226,624 @@ QVariant VmModel::data(const QModelIndex &index, int role) const
             if (index.column() == 0) return item->name;
             return QVariant(); // Only display name in column 0 for folders
         } else {
-            // DEBUG: Check VM data being accessed for display
+            // Hot path: compiled out of release builds (see Tracing.h)
             if (index.column() == 0) {
-                 qDebug() << "Data for VM:" << item->vmData.name 
-                          << "VMID:" << item->vmData.vmid 
-                          << "Status:" << item->vmData.status;
+                PVE_TRACE_EVENT("VmModel::data", item->vmid, index.row());
+                pveTraceHot(lcModelPaint) << "Data for VM:" << vmStore.nameAt(item->inventoryRow) 
+                                          << "VMID:" << item->vmid 
+                                          << "Status:" << vmStatusText(vmStore.statusAt(item->inventoryRow));
             }
             
-            // Display data for VMs
+            // Display data for VMs. Usage figures only mean something while the guest runs.
+            const int row = item->inventoryRow;
+            const bool running = vmStore.statusAt(row) == VmStatus::Running;
             switch (index.column()) {
-                case 0: return item->vmData.name;
+                case NameColumn: return vmStore.nameAt(row);
                 // FIX: Explicitly convert int to QString for safe QVariant storage
-                case 1: return QString::number(item->vmData.vmid); 
-                case 2: return item->vmData.status;
-                case 3: return item->vmData.type;
+                case VmidColumn: return QString::number(item->vmid); 
+                case StatusColumn: {
+                    auto pending = pendingActions.constFind(item->vmid);
+                    return pending != pendingActions.constEnd() ? transitionLabel(pending.value().action) : vmStatusText(vmStore.statusAt(row));
+                }
+                case TypeColumn: return vmTypeText(vmStore.typeAt(row));
+                case CpuColumn:
+                    if (!running) return QVariant();
+                    return QString("%1% of %2").arg(vmStore.cpuAt(row) * 100.0, 0, 'f', 1).arg(vmStore.maxcpuAt(row));
+                case MemoryColumn:
+                    if (!running) return QVariant();
+                    return QString("%1 / %2").arg(formatBytes(vmStore.memAt(row))).arg(formatBytes(vmStore.maxmemAt(row)));
+                case DiskColumn:
+                    // PVE reports usage for containers only; qemu guests show the size
+                    if (vmStore.maxdiskAt(row) <= 0) return QVariant();
+                    if (vmStore.diskAt(row) <= 0) return formatBytes(vmStore.maxdiskAt(row));
+                    return QString("%1 / %2").arg(formatBytes(vmStore.diskAt(row))).arg(formatBytes(vmStore.maxdiskAt(row)));
+                case NetInColumn:     return running ? QVariant(formatBytes(vmStore.netinAt(row))) : QVariant();
+                case NetOutColumn:    return running ? QVariant(formatBytes(vmStore.netoutAt(row))) : QVariant();
+                case DiskReadColumn:  return running ? QVariant(formatBytes(vmStore.diskreadAt(row))) : QVariant();
+                case DiskWriteColumn: return running ? QVariant(formatBytes(vmStore.diskwriteAt(row))) : QVariant();
+                case UptimeColumn:    return vmStore.uptimeAt(row) > 0 ? QVariant(formatUptime(vmStore.uptimeAt(row))) : QVariant();
+                case PoolColumn:      return vmStore.poolAt(row);
+                case TagsColumn:      return QString(vmStore.tagsAt(row)).replace(";", ", ");
+                case HaStateColumn:   return vmStore.hastateAt(row);
+                case TemplateColumn:  return vmStore.isTemplateAt(row) ? QVariant(QString("yes")) : QVariant();
             }
         }
     }
     
+    if (role == SortRole) {
+        if (item->isFolder) return index.column() == NameColumn ? QVariant(item->name) : QVariant();
+        return sortValue(item->inventoryRow, index.column());
+    }
+    
+    if (role == Qt::TextAlignmentRole && isNumericColumn(index.column())) {
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    
     if (role == Qt::DecorationRole && index.column() == 0) {
         if (item->isFolder) {
             return QIcon::fromTheme("folder");
         } else {
             // Logic for non-folder VM items
-            QString vmType = item->vmData.type.toLower();
-            
-            if (vmType == "qemu") {
+            VmType vmType = vmStore.typeAt(item->inventoryRow);
+            if (vmType == VmType::Qemu) {
                 return QIcon::fromTheme("computer"); 
-            } else if (vmType == "lxc") {
+            } else if (vmType == VmType::Lxc) {
                 // FIX: Change "server" to "system-monitor" to avoid folder icon confusion
                 return QIcon::fromTheme("system-monitor"); 
             }
         }
     }
     
+    // Cached inventory: readable but visibly not live
+    if (stale) {
+        if (role == Qt::ForegroundRole) return QColor(Qt::gray);
+        if (role == Qt::FontRole) {
+            QFont font;
+            font.setItalic(true);
+            return font;
+        }
+    }
+    
     return QVariant();
 }
 
+// ----------------------------------------------------
+// Sorting
+// ----------------------------------------------------
+
+template<class T>
+static int compareValues(const T& a, const T& b)
+{
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+// What a column sorts by: the raw number behind the text (Disk: the size, which every guest reports)
+QVariant VmModel::sortValue(int row, int column) const
+{
+    switch (column) {
+        case NameColumn:      return vmStore.nameAt(row);
+        case VmidColumn:      return vmStore.vmidAt(row);
+        case StatusColumn:    return vmStatusText(vmStore.statusAt(row));
+        case TypeColumn:      return vmTypeText(vmStore.typeAt(row));
+        case CpuColumn:       return vmStore.cpuAt(row);
+        case MemoryColumn:    return vmStore.memAt(row);
+        case DiskColumn:      return vmStore.maxdiskAt(row);
+        case NetInColumn:     return vmStore.netinAt(row);
+        case NetOutColumn:    return vmStore.netoutAt(row);
+        case DiskReadColumn:  return vmStore.diskreadAt(row);
+        case DiskWriteColumn: return vmStore.diskwriteAt(row);
+        case UptimeColumn:    return vmStore.uptimeAt(row);
+        case PoolColumn:      return vmStore.poolAt(row);
+        case TagsColumn:      return vmStore.tagsAt(row);
+        case HaStateColumn:   return vmStore.hastateAt(row);
+        case TemplateColumn:  return vmStore.isTemplateAt(row);
+    }
+    return QVariant();
+}
+
+// Same order as sortValue(), compared on the typed columns (no QVariant per comparison)
+int VmModel::compareVmRows(int rowA, int rowB, int column) const
+{
+    switch (column) {
+        case NameColumn:      return vmStore.nameAt(rowA).compare(vmStore.nameAt(rowB));
+        case VmidColumn:      return compareValues(vmStore.vmidAt(rowA), vmStore.vmidAt(rowB));
+        case StatusColumn:    return vmStatusText(vmStore.statusAt(rowA)).compare(vmStatusText(vmStore.statusAt(rowB)));
+        case TypeColumn:      return vmTypeText(vmStore.typeAt(rowA)).compare(vmTypeText(vmStore.typeAt(rowB)));
+        case CpuColumn:       return compareValues(vmStore.cpuAt(rowA), vmStore.cpuAt(rowB));
+        case MemoryColumn:    return compareValues(vmStore.memAt(rowA), vmStore.memAt(rowB));
+        case DiskColumn:      return compareValues(vmStore.maxdiskAt(rowA), vmStore.maxdiskAt(rowB));
+        case NetInColumn:     return compareValues(vmStore.netinAt(rowA), vmStore.netinAt(rowB));
+        case NetOutColumn:    return compareValues(vmStore.netoutAt(rowA), vmStore.netoutAt(rowB));
+        case DiskReadColumn:  return compareValues(vmStore.diskreadAt(rowA), vmStore.diskreadAt(rowB));
+        case DiskWriteColumn: return compareValues(vmStore.diskwriteAt(rowA), vmStore.diskwriteAt(rowB));
+        case UptimeColumn:    return compareValues(vmStore.uptimeAt(rowA), vmStore.uptimeAt(rowB));
+        case PoolColumn:      return vmStore.poolAt(rowA).compare(vmStore.poolAt(rowB));
+        case TagsColumn:      return vmStore.tagsAt(rowA).compare(vmStore.tagsAt(rowB));
+        case HaStateColumn:   return vmStore.hastateAt(rowA).compare(vmStore.hastateAt(rowB));
+        case TemplateColumn:  return compareValues(vmStore.isTemplateAt(rowA), vmStore.isTemplateAt(rowB));
+    }
+    return 0;
+}
+
+/**
+ * @brief Order of two siblings: under the root when !inFolder, inside a folder otherwise.
+ * Ties fall back to the VMID, so the order is total and refreshes never shuffle equal rows.
+ */
+bool VmModel::lessThan(const TreeItem *a, const TreeItem *b, bool inFolder) const
+{
+    if (sortColumn < 0) {
+        if (inFolder) return a->vmid < b->vmid;
+        const QString& nameA = displayName(a);
+        const QString& nameB = displayName(b);
+        if (nameA != nameB) return nameA < nameB;
+        if (a->isFolder != b->isFolder) return a->isFolder;
+        return a->vmid < b->vmid;
+    }
+
+    const bool descending = sortOrder == Qt::DescendingOrder;
+    if (a->isFolder || b->isFolder) {
+        // Folders only have a name: by any other column they stay together at the top
+        if (sortColumn != NameColumn && a->isFolder != b->isFolder) return a->isFolder;
+        int c = displayName(a).compare(displayName(b));
+        if (c != 0) return descending ? c > 0 : c < 0;
+        return a->isFolder && !b->isFolder;
+    }
+
+    int c = compareVmRows(a->inventoryRow, b->inventoryRow, sortColumn);
+    if (c != 0) return descending ? c > 0 : c < 0;
+    return a->vmid < b->vmid;
+}
+
+void VmModel::sort(int column, Qt::SortOrder order)
+{
+    sortColumn = (column >= 0 && column < ColumnCount) ? column : -1;
+    sortOrder = order;
+    applySortOrder();
+}
+
+/**
+ * @brief Puts every level back in sort order. Levels already in order are left alone
+ * (an O(n) check), so a refresh that changed no sort key costs no layout change; the
+ * rest are sorted under a single layoutAboutToBeChanged/layoutChanged pair with the
+ * persistent indexes (selection, current item) carried over.
+ */
+bool VmModel::applySortOrder()
+{
+    QVector<TreeItem*> unsorted;
+    auto check = [&](TreeItem *parentItem, bool inFolder) {
+        auto less = [this, inFolder](const TreeItem *a, const TreeItem *b) { return lessThan(a, b, inFolder); };
+        if (!std::is_sorted(parentItem->children.begin(), parentItem->children.end(), less)) unsorted.append(parentItem);
+    };
+    check(rootItem, false);
+    for (TreeItem *child : rootItem->children) {
+        if (child->isFolder) check(child, true);
+    }
+    if (unsorted.isEmpty()) return false;
+
+    emit layoutAboutToBeChanged();
+    const QModelIndexList before = persistentIndexList();
+    QVector<TreeItem*> beforeItems;
+    beforeItems.reserve(before.size());
+    for (const QModelIndex& index : before) {
+        beforeItems.append(getItem(index));
+    }
+
+    for (TreeItem *parentItem : unsorted) {
+        const bool inFolder = parentItem != rootItem;
+        std::sort(parentItem->children.begin(), parentItem->children.end(),
+                  [this, inFolder](const TreeItem *a, const TreeItem *b) { return lessThan(a, b, inFolder); });
+        parentItem->reindexChildren();
+    }
+
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (int i = 0; i < before.size(); ++i) {
+        after.append(createIndex(beforeItems[i]->row(), before[i].column(), beforeItems[i]));
+    }
+    changePersistentIndexList(before, after);
+    emit layoutChanged();
+    return true;
+}
+
 // ----------------------------------------------------
 // Data Population Logic
 // ----------------------------------------------------
-void VmModel::setVmList(const QVector<Vm>& vms)
+
+// Helper: QModelIndex (column 0) for an item, or the invalid index for the root
+QModelIndex VmModel::indexForItem(TreeItem *item) const
 {
-    beginResetModel();
-    
-    // 1. Clear existing data
-    qDeleteAll(rootItem->children);
-    rootItem->children.clear();
-    
-    // 2. Map to hold actual, user-defined folders (QString -> TreeItem*)
-    QMap<QString, TreeItem*> folders;
-    
-    // 3. Build the tree structure
+    if (!item || item == rootItem || !item->parent)
+        return QModelIndex();
+    return createIndex(item->row(), 0, item);
+}
+
+void VmModel::removeItem(TreeItem *item)
+{
+    TreeItem *parentItem = item->parent;
+    int row = item->row();
+
+    beginRemoveRows(indexForItem(parentItem), row, row);
+    parentItem->children.removeAt(row);
+    parentItem->reindexChildren(row);
+    unindexItem(item);
+    endRemoveRows();
+
+    itemPool.destroy(item);
+}
+
+/**
+ * @brief Rearranges parentItem's children so they start with exactly 'target', in order,
+ * using the smallest set of row moves/inserts. Items of 'target' that live under another
+ * parent are moved over (keeping selection), items without a parent are inserted.
+ * Children that are not in 'target' end up after it and are left for the caller.
+ * @return true if any row was inserted or moved.
+ */
+bool VmModel::reconcileChildren(TreeItem *parentItem, const QVector<TreeItem*>& target)
+{
+    bool changed = false;
+    QModelIndex parentIndex = indexForItem(parentItem);
+
+    // During a bulk rebuild the whole model is inside beginResetModel(), so no per-row signals
+    const bool notify = !rebuilding;
+
+    for (int i = 0; i < target.size(); ++i) {
+        TreeItem *wanted = target[i];
+        if (i < parentItem->children.size() && parentItem->children[i] == wanted)
+            continue;
+        changed = true;
+
+        if (wanted->parent == parentItem) {
+            // Reorder within the same parent (rows before i already match, so from > i)
+            int from = wanted->row();
+            if (notify) beginMoveRows(parentIndex, from, from, parentIndex, i);
+            parentItem->children.move(from, i);
+            parentItem->reindexChildren(i, from);
+            if (notify) endMoveRows();
+        } else if (wanted->parent) {
+            // Move from another folder (or the root)
+            TreeItem *oldParent = wanted->parent;
+            int from = wanted->row();
+            if (notify) beginMoveRows(indexForItem(oldParent), from, from, parentIndex, i);
+            oldParent->children.removeAt(from);
+            oldParent->reindexChildren(from);
+            parentItem->children.insert(i, wanted);
+            wanted->parent = parentItem;
+            parentItem->reindexChildren(i);
+            if (notify) endMoveRows();
+        } else {
+            // Brand new item
+            if (notify) beginInsertRows(parentIndex, i, i);
+            wanted->parent = parentItem;
+            parentItem->children.insert(i, wanted);
+            parentItem->reindexChildren(i);
+            if (notify) endInsertRows();
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Brings the tree in line with a fresh VM list, keyed by vmid.
+ * Instead of resetting the model, only the rows that actually differ are inserted,
+ * removed, moved or reported through dataChanged, so selection and expansion state
+ * survive and an unchanged refresh causes no view work at all.
+ * The first load (or a list sharing no VM with the tree, e.g. another cluster) is
+ * built in one pass under a model reset instead, releasing the old arena in bulk.
+ * @return true if the tree structure changed (rows inserted, removed or moved).
+ */
+bool VmModel::setVmList(const QVector<Vm>& vms)
+{
+    bool layoutChanged = false;
+
+    // 1. Desired grouping: custom folder (by folderKey) -> VMs, plus standalone VMs at the root.
+    // Treat "Unassigned" (likely the parser's default) as a root-level item.
+    // The first spelling seen for a folder is the one displayed.
+    QMap<QString, QVector<const Vm*>> desiredFolders;
+    QHash<QString, QString> folderDisplayNames;
+    QVector<const Vm*> rootVms;
+    QSet<int> incoming;
     for (const Vm& vm : vms) {
-        // NOTE: Assuming Vm struct has a 'folder' member (previously 'folderTag')
+        if (incoming.contains(vm.vmid)) continue; // vmids are unique per cluster
+        incoming.insert(vm.vmid);
+
         QString folderName = vm.folder.trimmed();
-        
-        // Treat "Unassigned" (likely the parser's default) as a root-level item.
-        // This makes the list flat by default.
         if (folderName.isEmpty() || folderName.toLower() == "unassigned") {
-            // SCENARIO 1: No Folder Tag or 'Unassigned' default. Display VM directly under root.
-            
-            // Create the VM item and add it directly to the root
-            // *** FIX CONSTRUCTOR CALL ***: Use TreeItem(const Vm& data, TreeItem *parentItem)
-            TreeItem* vmItem = new TreeItem(vm, rootItem); 
-            rootItem->children.append(vmItem);
+            rootVms.append(&vm);
         } else {
-            // SCENARIO 2: A custom Folder Tag is present. Group VM under a folder item.
-
-            // Find or create the custom folder item
-            TreeItem* folderItem;
-            if (!folders.contains(folderName)) {
-                // Create new folder, child of rootItem
-                // *** FIX CONSTRUCTOR CALL ***: Use TreeItem(const QString& itemName, bool folder, TreeItem *parentItem)
-                folderItem = new TreeItem(folderName, true, rootItem); 
-                folders.insert(folderName, folderItem);
-                rootItem->children.append(folderItem);
-            } else {
-                folderItem = folders.value(folderName);
-            }
-            
-            // Create the VM item and add it to the folder
-            // *** FIX CONSTRUCTOR CALL ***: Use TreeItem(const Vm& data, TreeItem *parentItem)
-            TreeItem* vmItem = new TreeItem(vm, folderItem);
-            folderItem->children.append(vmItem);
+            QString key = folderKey(folderName);
+            if (!folderDisplayNames.contains(key)) folderDisplayNames.insert(key, folderName);
+            desiredFolders[key].append(&vm);
         }
     }
-    
-    // 4. Sorting: 
-    // Sort top-level items (Folders and standalone VMs) alphabetically by name/folder name.
-    std::sort(rootItem->children.begin(), rootItem->children.end(), 
-              [](const TreeItem* a, const TreeItem* b) { 
-                return a->name < b->name; 
-              });
-
-    // Sort VMs within each folder by VMID
-    for (TreeItem* folder : rootItem->children) {
-        if (folder->isFolder) { // Only sort children of actual folder items
-            std::sort(folder->children.begin(), folder->children.end(), 
-                      [](const TreeItem* a, const TreeItem* b) { return a->vmData.vmid < b->vmData.vmid; });
+
+    // Bulk path: nothing to preserve, so drop the whole tree and rebuild without row signals
+    bool anyKnown = false;
+    for (int vmid : incoming) {
+        if (vmIndex.contains(vmid)) { anyKnown = true; break; }
+    }
+    if (!anyKnown && (!vms.isEmpty() || !vmIndex.isEmpty())) {
+        beginResetModel();
+        rebuilding = true;
+        itemPool.releaseAll();
+        vmIndex.clear();
+        vmStore.clear();
+        folderIndex.clear();
+        userFolders.clear();   // Made for the previous list
+        rootItem = itemPool.createFolder("Root");
+        layoutChanged = true;
+    }
+
+    // Folders the user created stay (empty) until VMs are moved into them; the server
+    // only knows folders that hold a VM, so they would otherwise vanish on the next poll
+    for (const QString& key : userFolders) {
+        TreeItem *folderItem = folderIndex.value(key, nullptr);
+        if (folderItem && !desiredFolders.contains(key)) {
+            desiredFolders.insert(key, {});
+            folderDisplayNames.insert(key, folderItem->name);
         }
     }
 
-    endResetModel();
+    // 2. Remove VMs that are gone (the snapshot keeps vmIndex iteration safe)
+    const QList<TreeItem*> currentVms = vmIndex.values();
+    for (TreeItem *item : currentVms) {
+        if (!incoming.contains(item->vmid)) {
+            removeItem(item);
+            layoutChanged = true;
+        }
+    }
+
+    // 3. Folders currently in the tree, then make sure every desired one exists
+    // (new folders are positioned and inserted in step 5)
+    QHash<QString, TreeItem*> existingFolders = folderIndex;
+    for (auto it = desiredFolders.constBegin(); it != desiredFolders.constEnd(); ++it) {
+        if (!folderIndex.contains(it.key())) {
+            TreeItem *folderItem = itemPool.createFolder(folderDisplayNames.value(it.key()));
+            folderIndex.insert(it.key(), folderItem);
+        }
+    }
+
+    // 4. Resolve each incoming VM to its item, writing its fields into the inventory
+    QSet<TreeItem*> changedItems;
+    auto itemFor = [&](const Vm *vm) -> TreeItem* {
+        bool changed = false;
+        int row = vmStore.upsert(*vm, &changed);
+        TreeItem *item = vmIndex.value(vm->vmid, nullptr);
+        if (!item) {
+            item = itemPool.createVm(vm->vmid, row); // Inserted by reconcileChildren
+            vmIndex.insert(vm->vmid, item);
+            return item;
+        }
+        if (changed) changedItems.insert(item);
+        return item;
+    };
+
+    // Rows already under a parent keep their current order and the others follow in sort
+    // order. Values change on every refresh (CPU, memory, ...), so re-sorting here would
+    // move rows one by one; step 8 re-sorts whatever is out of place in one layout change.
+    auto placement = [this](const TreeItem *parentItem, bool inFolder) {
+        return [this, parentItem, inFolder](const TreeItem *a, const TreeItem *b) {
+            const bool aHere = a->parent == parentItem;
+            const bool bHere = b->parent == parentItem;
+            if (aHere != bHere) return aHere;
+            if (aHere) return a->row() < b->row();
+            return lessThan(a, b, inFolder);
+        };
+    };
+
+    // 5. Root level: folders and standalone VMs
+    QVector<TreeItem*> rootTarget;
+    for (auto it = desiredFolders.constBegin(); it != desiredFolders.constEnd(); ++it) {
+        rootTarget.append(folderIndex.value(it.key()));
+    }
+    for (const Vm *vm : rootVms) {
+        rootTarget.append(itemFor(vm));
+    }
+    std::sort(rootTarget.begin(), rootTarget.end(), placement(rootItem, false));
+    layoutChanged |= reconcileChildren(rootItem, rootTarget);
+
+    // 6. VMs within each folder
+    for (auto it = desiredFolders.constBegin(); it != desiredFolders.constEnd(); ++it) {
+        TreeItem *folderItem = folderIndex.value(it.key());
+        QVector<TreeItem*> folderTarget;
+        for (const Vm *vm : it.value()) {
+            folderTarget.append(itemFor(vm));
+        }
+        std::sort(folderTarget.begin(), folderTarget.end(), placement(folderItem, true));
+        layoutChanged |= reconcileChildren(folderItem, folderTarget);
+    }
+
+    // 7. Folders that no longer hold any VM (their children were moved or removed above),
+    // except the user's own (see above)
+    for (auto it = existingFolders.begin(); it != existingFolders.end(); ++it) {
+        if (!desiredFolders.contains(it.key())) {
+            removeItem(it.value());
+            layoutChanged = true;
+        }
+    }
+
+    // 7b. Pending actions the new list confirms (or whose VM is gone) are resolved
+    for (auto it = pendingActions.begin(); it != pendingActions.end();) {
+        TreeItem *item = vmIndex.value(it.key(), nullptr);
+        if (!item) {
+            it = pendingActions.erase(it);
+        } else if (pendingActionReached(item)) {
+            it = pendingActions.erase(it);
+            changedItems.insert(item);
+        } else {
+            ++it;
+        }
+    }
+
+    if (rebuilding) {
+        // Every item was new, so step 5/6 already placed them all in sort order
+        rebuilding = false;
+        endResetModel();
+        return layoutChanged;
+    }
+
+    // 8. Restore the sort order where changed values broke it, then repaint only the
+    // rows whose data changed
+    layoutChanged |= applySortOrder();
+    for (TreeItem *item : changedItems) {
+        int row = item->row();
+        emit dataChanged(createIndex(row, 0, item), createIndex(row, columnCount() - 1, item));
+    }
+
+    return layoutChanged;
+}
+
+/**
+ * @brief Updates a single VM row in place (O(1) lookup), e.g. from a status poller.
+ * Only the data is updated; folder placement is left to setVmList.
+ * @return false if the VM is not in the tree.
+ */
+bool VmModel::updateVm(const Vm& vm)
+{
+    TreeItem *item = findVmItem(vm.vmid);
+    if (!item) return false;
+
+    Vm updated = vm;
+    updated.folder = vmStore.folderAt(item->inventoryRow);
+    bool changed = false;
+    vmStore.upsert(updated, &changed);
+    if (pendingActions.contains(vm.vmid) && pendingActionReached(item)) {
+        pendingActions.remove(vm.vmid);
+        changed = true;
+    }
+    if (changed) emitRowChanged(item);
+    return true;
+}
+
+/**
+ * @brief Sets a VM's status and name as just read from its node, e.g. after its task
+ * ended. The metrics stay as the last poll left them.
+ * @return false if the VM is not in the tree.
+ */
+bool VmModel::updateVmStatus(int vmid, const QString& status, const QString& name)
+{
+    TreeItem *item = findVmItem(vmid);
+    if (!item) return false;
+
+    const int row = item->inventoryRow;
+    bool changed = false;
+    if (!status.isEmpty() && vmStore.statusAt(row) != vmStatusFromString(status)) {
+        vmStore.setStatus(row, vmStatusFromString(status));
+        changed = true;
+    }
+    if (!name.isEmpty() && vmStore.nameAt(row) != name) {
+        vmStore.setName(row, name);
+        changed = true;
+    }
+    if (pendingActions.contains(vmid) && pendingActionReached(item)) {
+        pendingActions.remove(vmid);
+        changed = true;
+    }
+    if (changed) emitRowChanged(item);
+    return true;
+}
+
+void VmModel::emitRowChanged(TreeItem *item)
+{
+    int row = item->row();
+    emit dataChanged(createIndex(row, 0, item), createIndex(row, columnCount() - 1, item));
+}
+
+// ----------------------------------------------------
+// OPTIMISTIC POWER ACTIONS
+// ----------------------------------------------------
+
+// A reboot starts and ends "running", so only the task result can resolve it
+bool VmModel::pendingActionReached(const TreeItem *item) const
+{
+    const PendingAction& pending = pendingActions[item->vmid];
+    return pending.fromStatus != pending.targetStatus && vmStore.statusAt(item->inventoryRow) == pending.targetStatus;
+}
+
+void VmModel::beginPendingAction(int vmid, const QString& action)
+{
+    TreeItem *item = findVmItem(vmid);
+    if (!item) return;
+
+    PendingAction pending;
+    pending.action = action;
+    pending.fromStatus = vmStore.statusAt(item->inventoryRow);
+    pending.targetStatus = targetStatusFor(action);
+    pendingActions.insert(vmid, pending);
+    emitRowChanged(item);
+}
+
+/**
+ * @brief The action's task succeeded: show the status it leads to right away. A later
+ * updateVm/updateVmStatus/setVmList still overwrites it with what the server reports.
+ */
+void VmModel::completePendingAction(int vmid)
+{
+    auto it = pendingActions.find(vmid);
+    if (it == pendingActions.end()) return;
+
+    VmStatus target = it.value().targetStatus;
+    pendingActions.erase(it);
+    if (TreeItem *item = findVmItem(vmid)) {
+        vmStore.setStatus(item->inventoryRow, target);
+        emitRowChanged(item);
+    }
+}
+
+// The action or its task failed: the row falls back to the last status the server reported
+void VmModel::rollbackPendingAction(int vmid)
+{
+    if (!pendingActions.remove(vmid)) return;
+    if (TreeItem *item = findVmItem(vmid)) emitRowChanged(item);
+}
+
+/**
+ * @brief Marks every row as stale (cached) or live. Repaints whole sibling ranges,
+ * one dataChanged per parent, since only the styling roles change.
+ */
+void VmModel::setStale(bool isStale)
+{
+    if (stale == isStale) return;
+    stale = isStale;
+
+    const QVector<int> roles{Qt::ForegroundRole, Qt::FontRole};
+    std::function<void(TreeItem*)> repaint = [&](TreeItem *parentItem) {
+        if (parentItem->children.isEmpty()) return;
+        QModelIndex parentIndex = indexForItem(parentItem);
+        emit dataChanged(index(0, 0, parentIndex),
+                         index(parentItem->childCount() - 1, columnCount() - 1, parentIndex),
+                         roles);
+        for (TreeItem *child : parentItem->children) {
+            if (child->isFolder) repaint(child);
+        }
+    };
+    repaint(rootItem);
+}
+
+/**
+ * @brief Memory used by the tree: pooled item storage plus the heap blocks each
+ * item owns (child pointer arrays and string payloads). Walks the tree, so call
+ * it for diagnostics only.
+ */
+VmModel::MemoryStats VmModel::memoryStats() const
+{
+    MemoryStats stats;
+    stats.pool = itemPool.stats();
+    stats.vmCount = vmIndex.size();
+
+    std::function<void(const TreeItem*)> walk = [&](const TreeItem *item) {
+        stats.childArrayBytes += static_cast<qint64>(item->children.capacity()) * sizeof(TreeItem*);
+        stats.stringBytes += static_cast<qint64>(item->name.capacity()) * sizeof(QChar);
+        for (const TreeItem *child : item->children) {
+            walk(child);
+        }
+    };
+    walk(rootItem);
+
+    stats.inventoryBytes = vmStore.bytes();
+
+    qint64 total = stats.pool.slabBytes + stats.childArrayBytes + stats.stringBytes + stats.inventoryBytes;
+    stats.bytesPerVm = stats.vmCount > 0 ? static_cast<double>(total) / stats.vmCount : 0.0;
+    return stats;
 }
 
 // ----------------------------------------------------
@@ -279,8 +857,8 @@ bool VmModel::createFolder(const QString& name)
 
     // Check for conflict with existing top-level folders or VMs
     for (const TreeItem* item : rootItem->children) {
-        if (item->name.toLower() == trimmedName.toLower()) {
-            qDebug() << "Folder or VM named" << trimmedName << "already exists at the root.";
+        if (displayName(item).toLower() == trimmedName.toLower()) {
+            qCDebug(lcModel) << "Folder or VM named" << trimmedName << "already exists at the root.";
             return false;
         }
     }
@@ -289,18 +867,16 @@ bool VmModel::createFolder(const QString& name)
     beginInsertRows(QModelIndex(), rootItem->children.count(), rootItem->children.count());
     
     // 2. Create the new folder item as a child of the root
-    // *** FIX CONSTRUCTOR CALL ***: Use TreeItem(const QString& itemName, bool folder, TreeItem *parentItem)
-    TreeItem* newFolder = new TreeItem(trimmedName, true, rootItem); 
-    rootItem->children.append(newFolder);
+    TreeItem* newFolder = itemPool.createFolder(trimmedName, rootItem); 
+    rootItem->appendChild(newFolder);
+    indexItem(newFolder);
+    userFolders.insert(folderKey(trimmedName));
     
     // 3. Notify the view that rows have been inserted
     endInsertRows();
 
-    // OPTIONAL: Re-sort the root level after insertion to maintain order
-    // Note: Re-sorting immediately causes issues with Qt's index management. 
-    // It's better to rely on the next refresh or use QSortFilterProxyModel. 
-    // For manual creation, we'll skip the immediate sort for stability.
-    
+    // 4. Move it to its sorted place among the root's items (one layout change)
+    applySortOrder();
     return true;
 }
 
@@ -310,48 +886,44 @@ bool VmModel::assignVmToFolder(int vmid, const QString& folderName)
     TreeItem* destinationFolder = findFolderItem(folderName);
 
     if (!vmItem || !destinationFolder || !destinationFolder->isFolder) {
-        qDebug() << "Cannot assign VM:" << vmid << "to folder:" << folderName << ". Item(s) not found or folder is invalid.";
+        qCDebug(lcModel) << "Cannot assign VM:" << vmid << "to folder:" << folderName << ". Item(s) not found or folder is invalid.";
         return false;
     }
     
     TreeItem* currentParent = vmItem->parent;
+    vmStore.setFolder(vmItem->inventoryRow, destinationFolder->name);
     if (currentParent == destinationFolder) {
-        qDebug() << "VM is already in the destination folder.";
+        qCDebug(lcModel) << "VM is already in the destination folder.";
         return true;
     }
 
     // 1. Remove the VM from its current parent
-    int oldRow = currentParent->children.indexOf(vmItem);
-    if (oldRow >= 0) {
+    int oldRow = vmItem->row();
+    if (oldRow >= 0 && oldRow < currentParent->children.count() && currentParent->children[oldRow] == vmItem) {
         // Get the QModelIndex for the current parent before removal
-        QModelIndex parentIndex = (currentParent == rootItem) ? QModelIndex() : createIndex(currentParent->row(), 0, currentParent->parent);
+        QModelIndex parentIndex = indexForItem(currentParent);
         
         beginRemoveRows(parentIndex, oldRow, oldRow);
         currentParent->children.removeAt(oldRow);
+        currentParent->reindexChildren(oldRow);
         endRemoveRows();
     } else {
-        qDebug() << "Error: VM not found in its expected parent's children list.";
+        qCDebug(lcModel) << "Error: VM not found in its expected parent's children list.";
         return false;
     }
 
     // 2. Insert the VM into the new destination folder
     int newRow = destinationFolder->children.count();
     // Get the QModelIndex for the destination parent
-    QModelIndex destIndex = (destinationFolder == rootItem) ? QModelIndex() : createIndex(destinationFolder->row(), 0, destinationFolder->parent);
+    QModelIndex destIndex = indexForItem(destinationFolder);
 
     beginInsertRows(destIndex, newRow, newRow);
-    destinationFolder->children.append(vmItem);
+    destinationFolder->appendChild(vmItem);
     vmItem->parent = destinationFolder; // Update parent pointer
     endInsertRows();
 
-    // Optional: Re-sort the destination folder children
-    std::sort(destinationFolder->children.begin(), destinationFolder->children.end(), 
-              [](const TreeItem* a, const TreeItem* b) { return a->vmData.vmid < b->vmData.vmid; });
-              
-    // Since the index might have changed due to the sort, we notify the view
-    // that the data in the folder might have changed (for the whole column 0)
-    emit dataChanged(index(0, 0, destIndex), 
-                     index(destinationFolder->children.count() - 1, 0, destIndex));
+    // Move it to its sorted place among the folder's VMs
+    applySortOrder();
 
     return true;
 }
@@ -374,6 +946,70 @@ bool VmModel::isRootParent(const TreeItem* item) const
     return item && (item->parent == rootItem);
 }
 
-// NOTE: This implementation relies on VmModel.h having the two TreeItem constructors:
-// 1. explicit TreeItem(const QString& itemName, bool folder = true, TreeItem *parentItem = nullptr)
-// 2. explicit TreeItem(const Vm& data, TreeItem *parentItem = nullptr)
\ No newline at end of file
+// --- BENCHMARK ---
+
+QString VmModel::benchmark(int items)
+{
+    const int FOLDER_SIZE = 2000;
+    const int VISIBLE_ROWS = 40;   // One page of a maximized tree view
+
+    QVector<Vm> vms;
+    vms.reserve(items);
+    for (int i = 0; i < items; ++i) {
+        Vm vm;
+        vm.vmid = 100 + i;
+        vm.type = (i % 4 == 0) ? QStringLiteral("lxc") : QStringLiteral("qemu");
+        vm.status = (i % 10 < 7) ? QStringLiteral("running") : QStringLiteral("stopped");
+        vm.node = QString("pve-node-%1").arg(i % 32, 2, 10, QChar('0'));
+        vm.name = QString("guest-%1").arg(i);
+        vm.folder = QString("Folder %1").arg(i / FOLDER_SIZE);
+        vm.maxmem = qint64(4) << 30;
+        vm.mem = vm.maxmem / 2;
+        vms.append(vm);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    VmModel model;
+    model.setVmList(vms);
+    const qint64 loadMs = timer.elapsed();
+
+    // Scroll every folder from top to bottom, one page per step, touching each visible
+    // cell like a view does; 'parentOf' is the parent() implementation under test
+    qint64 cells = 0;
+    int mismatches = 0;
+    auto scroll = [&](auto parentOf) {
+        cells = 0;
+        QElapsedTimer elapsed;
+        elapsed.start();
+        for (int f = 0; f < model.rowCount(); ++f) {
+            const QModelIndex folder = model.index(f, 0);
+            const int rows = model.rowCount(folder);
+            for (int top = 0; top < rows; top += VISIBLE_ROWS) {
+                for (int row = top; row < qMin(rows, top + VISIBLE_ROWS); ++row) {
+                    for (int column = 0; column < ColumnCount; ++column) {
+                        const QModelIndex cell = model.index(row, column, folder);
+                        if (parentOf(cell).row() != f) mismatches++;
+                        model.data(cell, Qt::DisplayRole);
+                        cells++;
+                    }
+                }
+            }
+        }
+        return elapsed.nsecsElapsed();
+    };
+
+    // Current parent(): the folder's cached row
+    const qint64 cachedNs = scroll([&model](const QModelIndex& cell) { return model.parent(cell); });
+    // Former parent(): parentItem->row() scanned the root's children for the folder
+    const qint64 scanNs = scroll([&model](const QModelIndex& cell) {
+        TreeItem *folderItem = model.getItem(cell)->parent;
+        return model.createIndex(model.rootItem->children.indexOf(folderItem), 0, folderItem);
+    });
+
+    return QString("Scroll benchmark, %1 VMs in %2 folders of %3: load %4 ms; full scroll (%5 cells incl. data()) "
+                   "with cached rows %6 ms (%7 ns/cell) vs former root scan %8 ms (%9 ns/cell), %10 mismatches")
+        .arg(items).arg(model.rowCount()).arg(FOLDER_SIZE).arg(loadMs)
+        .arg(cells).arg(cachedNs / 1000000).arg(cells > 0 ? cachedNs / cells : 0)
+        .arg(scanNs / 1000000).arg(cells > 0 ? scanNs / cells : 0).arg(mismatches);
+}
@@ -3,8 +3,12 @@
 
 #include <QAbstractItemModel>
 #include <QVector>
+#include <QHash>
+#include <QSet>
 #include <QStringList> 
 #include "ProxmoxApiManager.h" // For Vm struct
+#include "TreeItemPool.h"
+#include "VmInventory.h"
 
 // --- TreeItem Structure Definition ---
 // MUST BE DEFINED BEFORE VmModel uses it, or use a forward declaration + full definition later.
@@ -14,32 +18,42 @@ struct TreeItem
     // C++ Model/View members
     TreeItem *parent;                 // Required for model traversal (Error 315, 316)
     QVector<TreeItem*> children;      // List of child items (for folders or root)
+    int rowInParent = 0;              // Cached index in parent->children (see reindexChildren)
 
     // Data members
     bool isFolder;                    // Flag to distinguish between a Folder and a VM (Error 233, 247, 287, 296)
-    QString name;                     // Display name (for Folders or VMs) (Error 332, 335)
+    QString name;                     // Display name of folders; VM names live in the inventory
     
-    // Proxmox VM Data (only valid if isFolder is false)
-    Vm vmData;                        // Holds VM details (vmid, status, etc.) (Error 234, 236, 331, etc.)
+    // Proxmox VM Data (only valid if isFolder is false): the VM's row in the owning
+    // model's VmInventory, which holds every field (see VmModel::vmFor)
+    qint32 vmid = 0;
+    int inventoryRow = -1;
 
     // Constructor for Folder (or Root)
     explicit TreeItem(const QString& itemName, bool folder = true, TreeItem *parentItem = nullptr)
         : parent(parentItem), isFolder(folder), name(itemName) {}
 
     // Constructor for VM
-    explicit TreeItem(const Vm& data, TreeItem *parentItem = nullptr)
-        : parent(parentItem), isFolder(false), name(data.name), vmData(data) {}
+    TreeItem(int vmId, int row, TreeItem *parentItem = nullptr)
+        : parent(parentItem), isFolder(false), vmid(vmId), inventoryRow(row) {}
     
-    // Destructor (recursively deletes children)
-    ~TreeItem() {
-        qDeleteAll(children);
-        children.clear();
-    }
+    // Items (and their children) are owned and destroyed by the model's TreeItemPool
+    ~TreeItem() = default;
 
     void appendChild(TreeItem *child) {
+        child->rowInParent = children.count();
         children.append(child);
     }
 
+    // Refreshes the cached rowInParent of children[from..to] (to = -1 means the last child).
+    // Must be called after any insert/remove/move/sort on 'children' so row() stays O(1).
+    void reindexChildren(int from = 0, int to = -1) {
+        int last = (to < 0 || to >= children.count()) ? children.count() - 1 : to;
+        for (int i = qMax(from, 0); i <= last; ++i) {
+            children[i]->rowInParent = i;
+        }
+    }
+
     TreeItem *child(int row) const {
         return children.value(row);
     }
@@ -48,7 +62,7 @@ struct TreeItem
         return children.count();
     }
 
-    int row() const; // Implementation will be in .cpp file
+    int row() const; // O(1): returns the cached rowInParent
 };
 
 
@@ -60,6 +74,15 @@ public:
     explicit VmModel(QObject *parent = nullptr);
     ~VmModel() override;
 
+    enum Column {
+        NameColumn, VmidColumn, StatusColumn, TypeColumn,
+        CpuColumn, MemoryColumn, DiskColumn, NetInColumn, NetOutColumn, DiskReadColumn, DiskWriteColumn,
+        UptimeColumn, PoolColumn, TagsColumn, HaStateColumn, TemplateColumn,
+        ColumnCount
+    };
+    // Raw cell value (number or string) behind the formatted DisplayRole text
+    static constexpr int SortRole = Qt::UserRole + 1;
+
     // --- Core QAbstractItemModel Overrides ---
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -67,9 +90,62 @@ public:
     QModelIndex parent(const QModelIndex &child) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    // Sorts the VMs of every level by 'column' (folders stay grouped at the top of the
+    // root); setVmList keeps the order as values change. Column -1 restores the default
+    // order: root by name, folders by VMID.
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 
     // --- Data Population Method ---
-    void setVmList(const QVector<Vm>& vms);
+    // Applies the list incrementally; returns true if rows were inserted, removed or moved.
+    bool setVmList(const QVector<Vm>& vms);
+    // Updates one VM's row in place via the vmid index; returns false if the VM is unknown.
+    bool updateVm(const Vm& vm);
+    // Patches only status and name (empty values are left alone), so a re-read after a
+    // task cannot overwrite newer polled metrics with an older record
+    bool updateVmStatus(int vmid, const QString& status, const QString& name);
+    
+    // Current item of a VM (O(1) via the vmid index), or nullptr once it has left the list.
+    // Item pointers do not survive setVmList (the pool reuses freed slots); keep the vmid.
+    TreeItem *findVmItem(int vmid) const;
+    // Full record of a VM item, read from the inventory
+    Vm vmFor(const TreeItem *item) const { return vmStore.toVm(item->inventoryRow); }
+    // Folder name, or the VM's name
+    QString displayName(const TreeItem *item) const { return item->isFolder ? item->name : vmStore.nameAt(item->inventoryRow); }
+    
+    // Column store behind the tree, for filters and sorting (read-only)
+    const VmInventory& inventory() const { return vmStore; }
+    
+    // Stale rows (a cached inventory shown before the live list arrives) are drawn greyed out.
+    void setStale(bool isStale);
+    bool isStale() const { return stale; }
+    
+    // --- Optimistic power actions ---
+    // A VM with a pending action shows a transitional status ("starting...") at once.
+    // The overlay ends when the action's task succeeds (the expected status is applied),
+    // when setVmList/updateVm/updateVmStatus report the target status, or on rollback (action failed).
+    void beginPendingAction(int vmid, const QString& action);
+    void completePendingAction(int vmid);
+    void rollbackPendingAction(int vmid);
+    bool hasPendingAction(int vmid) const { return pendingActions.contains(vmid); }
+
+    // --- Memory diagnostics ---
+    struct MemoryStats
+    {
+        TreeItemPool::Stats pool;
+        qint64 childArrayBytes = 0; // Heap used by the children pointer arrays
+        qint64 stringBytes = 0;     // Heap used by folder names in the tree
+        qint64 inventoryBytes = 0;  // VmInventory columns, index and interned strings
+        int vmCount = 0;
+        double bytesPerVm = 0.0;    // (pool + arrays + strings + inventory) / vmCount
+    };
+    MemoryStats memoryStats() const;
+    
+    // Builds a synthetic model of 'items' VMs (folders of 2,000) and scrolls through all
+    // of it a page at a time, calling index()/parent()/data() for every visible cell as a
+    // view does: once with the O(1) parent(), once with the former one, which scanned the
+    // root's children for the folder's row.
+    // Returns a summary line.
+    static QString benchmark(int items);
 
     // --- Folder Management Methods ---
     bool createFolder(const QString& name); 
@@ -81,10 +157,44 @@ public:
     // ------------------------------------------------------------------------
 
 private:
+    TreeItemPool itemPool; // Owns every TreeItem, including rootItem (declared first: destroyed last)
     TreeItem *rootItem; // <-- STILL PRIVATE
+    VmInventory vmStore;   // Every VM field, column by column; TreeItems point at its rows
+    bool rebuilding = false; // True while setVmList rebuilds the tree inside a model reset
+    bool stale = false;      // See setStale()
+    
+    // --- Sorting (see sort()) ---
+    int sortColumn = -1;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    bool lessThan(const TreeItem *a, const TreeItem *b, bool inFolder) const;
+    int compareVmRows(int rowA, int rowB, int column) const;   // <0, 0, >0 on the inventory values
+    QVariant sortValue(int row, int column) const;
+    bool applySortOrder();   // Re-sorts out-of-order levels under one layout change; true if rows moved
+    
+    struct PendingAction
+    {
+        QString action;
+        VmStatus fromStatus;     // Status when the action was sent
+        VmStatus targetStatus;   // Status the action leads to (running / stopped)
+    };
+    QHash<int, PendingAction> pendingActions;   // vmid -> action awaiting confirmation
+    bool pendingActionReached(const TreeItem *item) const;
+    void emitRowChanged(TreeItem *item);
+
+    // --- Lookup indexes (kept in sync on every insert/remove; moves keep pointers stable) ---
+    QHash<int, TreeItem*> vmIndex;          // vmid -> VM item
+    QHash<QString, TreeItem*> folderIndex;  // folderKey(name) -> top-level folder item
+    QSet<QString> userFolders;              // folderKeys made by createFolder; kept by setVmList while empty
+    static QString folderKey(const QString& folderName);
+    void indexItem(TreeItem *item);
+    void unindexItem(TreeItem *item);   // Also drops the inventory rows of VM items
     TreeItem *getItem(const QModelIndex &index) const;
-    TreeItem *findVmItem(int vmid) const; 
     TreeItem *findFolderItem(const QString& folderName) const; 
+
+    // --- Incremental update helpers (used by setVmList) ---
+    QModelIndex indexForItem(TreeItem *item) const;
+    void removeItem(TreeItem *item);
+    bool reconcileChildren(TreeItem *parentItem, const QVector<TreeItem*>& target);
 };
 
 
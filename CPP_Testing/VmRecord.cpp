@@ -0,0 +1,84 @@
+#include "VmRecord.h"
+
+// --- ENUM CONVERSION ---
+
+VmType vmTypeFromString(const QString& text)
+{
+    if (text == QLatin1String("qemu")) return VmType::Qemu;
+    if (text == QLatin1String("lxc")) return VmType::Lxc;
+    return VmType::Unknown;
+}
+
+VmStatus vmStatusFromString(const QString& text)
+{
+    if (text == QLatin1String("running")) return VmStatus::Running;
+    if (text == QLatin1String("stopped")) return VmStatus::Stopped;
+    if (text == QLatin1String("paused")) return VmStatus::Paused;
+    if (text == QLatin1String("suspended")) return VmStatus::Suspended;
+    if (text == QLatin1String("prelaunch")) return VmStatus::Prelaunch;
+    return VmStatus::Unknown;
+}
+
+// Returned strings are built from literals once and then shared (implicitly) by every caller
+QString vmTypeText(VmType type)
+{
+    static const QString qemu = QStringLiteral("qemu");
+    static const QString lxc = QStringLiteral("lxc");
+    switch (type) {
+        case VmType::Qemu: return qemu;
+        case VmType::Lxc:  return lxc;
+        default:           return QString();
+    }
+}
+
+QString vmStatusText(VmStatus status)
+{
+    static const QString names[] = {
+        QStringLiteral("unknown"), QStringLiteral("running"), QStringLiteral("stopped"),
+        QStringLiteral("paused"), QStringLiteral("suspended"), QStringLiteral("prelaunch")
+    };
+    return names[static_cast<int>(status)];
+}
+
+QString formatBytes(qint64 bytes)
+{
+    static const char *const units[] = {"KiB", "MiB", "GiB", "TiB", "PiB"};
+    if (bytes < 1024) return QString("%1 B").arg(bytes);
+    double value = bytes / 1024.0;
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        unit++;
+    }
+    return QString("%1 %2").arg(value, 0, 'f', 1).arg(units[unit]);
+}
+
+// --- StringTable ---
+
+StringTable::StringTable()
+{
+    strings.append(QString());
+    ids.insert(QString(), 0);
+}
+
+quint32 StringTable::intern(const QString& text)
+{
+    auto it = ids.constFind(text);
+    if (it != ids.constEnd()) return it.value();
+
+    quint32 id = static_cast<quint32>(strings.size());
+    strings.append(text);
+    ids.insert(text, id); // Shares the payload with strings[id]
+    return id;
+}
+
+qint64 StringTable::bytes() const
+{
+    qint64 total = static_cast<qint64>(strings.capacity()) * sizeof(QString);
+    for (const QString& text : strings) {
+        total += static_cast<qint64>(text.capacity()) * sizeof(QChar);
+    }
+    // One node per entry: key, value and the hash/next bookkeeping
+    total += static_cast<qint64>(ids.size()) * (sizeof(QString) + sizeof(quint32) + 2 * sizeof(void*));
+    return total;
+}
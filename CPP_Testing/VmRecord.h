@@ -0,0 +1,49 @@
+#ifndef VMRECORD_H
+#define VMRECORD_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// --- ENUM-ENCODED FIELDS ---
+// The handful of values PVE reports for guest type and status, one byte each instead
+// of a QString per VM. Values PVE may add later decode as Unknown.
+enum class VmType : quint8 { Unknown, Qemu, Lxc };
+enum class VmStatus : quint8 { Unknown, Running, Stopped, Paused, Suspended, Prelaunch };
+
+VmType vmTypeFromString(const QString& text);
+VmStatus vmStatusFromString(const QString& text);
+QString vmTypeText(VmType type);       // "qemu", "lxc", "" (unknown)
+QString vmStatusText(VmStatus status); // "running", "stopped", ..., "unknown"
+
+// "512 B", "1.5 KiB", ..., "3.2 TiB" (binary units, one decimal)
+QString formatBytes(qint64 bytes);
+
+// --- StringTable ---
+// Interns the strings many VMs have in common (node, folder and pool names). Each
+// distinct string is stored once and referred to by a 32-bit id; ids stay valid for
+// the table's lifetime, so records built from one refresh compare equal to the same
+// records from the next. Id 0 is the empty string. Not thread-safe: owned and used
+// by one thread (the model's).
+class StringTable
+{
+public:
+    StringTable();
+
+    static constexpr quint32 NoId = 0xFFFFFFFFu;
+
+    quint32 intern(const QString& text);
+    quint32 find(const QString& text) const { return ids.value(text, NoId); }  // NoId if never interned
+    const QString& text(quint32 id) const { return strings[id]; }
+    int size() const { return strings.size(); }
+
+    // Heap used by the table: string payloads, the id vector and the lookup hash (approximate)
+    qint64 bytes() const;
+
+private:
+    QVector<QString> strings;        // id -> string
+    QHash<QString, quint32> ids;     // string -> id
+};
+
+#endif // VMRECORD_H
@@ -0,0 +1,276 @@
+#include "VmResourceSaxParser.h"
+#include <QElapsedTimer>
+
+bool VmResourceSaxParser::parse(const std::string& body, QVector<Vm>& output, std::string *error)
+{
+    VmResourceSaxParser handler(output);
+    bool ok = json::sax_parse(body, &handler);
+    if (!ok && error) *error = handler.errorMessage();
+    return ok;
+}
+
+// --- RECORD ASSEMBLY ---
+
+void VmResourceSaxParser::beginRecord()
+{
+    // Same defaults the DOM path used via item.value(...)
+    type_std.clear();
+    current = Vm();
+    current.status = "N/A";
+    current.node = "N/A";
+    current.name = "N/A";
+}
+
+void VmResourceSaxParser::endRecord()
+{
+    if (type_std == "qemu" || type_std == "lxc") {
+        current.type = QString::fromStdString(type_std);
+        vms.push_back(current);
+    }
+}
+
+void VmResourceSaxParser::setIntegerField(long long val)
+{
+    if (inRecord()) {
+        switch (field) {
+            case Field::Vmid:      current.vmid = static_cast<int>(val); break;
+            case Field::Cpu:       current.cpu = static_cast<double>(val); break; // An idle guest reports 0
+            case Field::MaxCpu:    current.maxcpu = static_cast<int>(val); break;
+            case Field::Mem:       current.mem = val; break;
+            case Field::MaxMem:    current.maxmem = val; break;
+            case Field::Disk:      current.disk = val; break;
+            case Field::MaxDisk:   current.maxdisk = val; break;
+            case Field::NetIn:     current.netin = val; break;
+            case Field::NetOut:    current.netout = val; break;
+            case Field::DiskRead:  current.diskread = val; break;
+            case Field::DiskWrite: current.diskwrite = val; break;
+            case Field::Uptime:    current.uptime = val; break;
+            case Field::Template:  current.isTemplate = (val != 0); break;
+            default: break;
+        }
+    }
+    field = Field::None;
+}
+
+void VmResourceSaxParser::setNumberField(double val)
+{
+    if (field == Field::Cpu) {
+        if (inRecord()) current.cpu = val;
+        field = Field::None;
+        return;
+    }
+    // Everything else is a whole number, but PVE occasionally serializes counters as floats
+    setIntegerField(static_cast<long long>(val));
+}
+
+// --- SAX EVENTS ---
+
+bool VmResourceSaxParser::null()
+{
+    field = Field::None;
+    return true;
+}
+
+bool VmResourceSaxParser::boolean(bool)
+{
+    field = Field::None;
+    return true;
+}
+
+bool VmResourceSaxParser::number_integer(number_integer_t val)
+{
+    setIntegerField(val);
+    return true;
+}
+
+bool VmResourceSaxParser::number_unsigned(number_unsigned_t val)
+{
+    setIntegerField(static_cast<long long>(val));
+    return true;
+}
+
+bool VmResourceSaxParser::number_float(number_float_t val, const string_t&)
+{
+    setNumberField(val);
+    return true;
+}
+
+bool VmResourceSaxParser::string(string_t& val)
+{
+    if (inRecord()) {
+        switch (field) {
+            case Field::Type:     type_std = val; break;
+            case Field::Status:   current.status = QString::fromStdString(val); break;
+            case Field::Node:     current.node = QString::fromStdString(val); break;
+            case Field::Name:     current.name = QString::fromStdString(val); break;
+            case Field::Pool:     current.pool = QString::fromStdString(val); break;
+            case Field::Tags:     current.tags = QString::fromStdString(val); break;
+            case Field::HaState:  current.hastate = QString::fromStdString(val); break;
+            default: break;
+        }
+    }
+    field = Field::None;
+    return true;
+}
+
+bool VmResourceSaxParser::binary(binary_t&)
+{
+    field = Field::None;
+    return true;
+}
+
+bool VmResourceSaxParser::start_object(std::size_t)
+{
+    depth++;
+    field = Field::None;
+    if (in_data_array && depth == 3) beginRecord();
+    return true;
+}
+
+bool VmResourceSaxParser::key(string_t& val)
+{
+    if (depth == 1) {
+        data_key_pending = (val == "data");
+        return true;
+    }
+    if (inRecord()) {
+        if (val == "type")           field = Field::Type;
+        else if (val == "vmid")      field = Field::Vmid;
+        else if (val == "status")    field = Field::Status;
+        else if (val == "node")      field = Field::Node;
+        else if (val == "name")      field = Field::Name;
+        else if (val == "pool")      field = Field::Pool;
+        else if (val == "tags")      field = Field::Tags;
+        else if (val == "hastate")   field = Field::HaState;
+        else if (val == "cpu")       field = Field::Cpu;
+        else if (val == "maxcpu")    field = Field::MaxCpu;
+        else if (val == "mem")       field = Field::Mem;
+        else if (val == "maxmem")    field = Field::MaxMem;
+        else if (val == "disk")      field = Field::Disk;
+        else if (val == "maxdisk")   field = Field::MaxDisk;
+        else if (val == "netin")     field = Field::NetIn;
+        else if (val == "netout")    field = Field::NetOut;
+        else if (val == "diskread")  field = Field::DiskRead;
+        else if (val == "diskwrite") field = Field::DiskWrite;
+        else if (val == "uptime")    field = Field::Uptime;
+        else if (val == "template")  field = Field::Template;
+        else                         field = Field::None;
+    }
+    return true;
+}
+
+bool VmResourceSaxParser::end_object()
+{
+    if (inRecord()) endRecord();
+    depth--;
+    return true;
+}
+
+bool VmResourceSaxParser::start_array(std::size_t)
+{
+    depth++;
+    field = Field::None;
+    if (depth == 2 && data_key_pending) {
+        in_data_array = true;
+    }
+    return true;
+}
+
+bool VmResourceSaxParser::end_array()
+{
+    if (depth == 2 && in_data_array) {
+        in_data_array = false;
+        data_key_pending = false;
+    }
+    depth--;
+    return true;
+}
+
+bool VmResourceSaxParser::parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex)
+{
+    error_message = ex.what();
+    return false;
+}
+
+// --- BENCHMARK ---
+
+// The parse the SAX handler replaced: full DOM, then per-field lookups
+static int parseWithDom(const std::string& body, QVector<Vm>& output)
+{
+    json response = json::parse(body);
+    for (const auto& item : response["data"]) {
+        std::string type_std = item.value("type", "");
+        if (type_std != "qemu" && type_std != "lxc") continue;
+        Vm vm;
+        vm.vmid = item.value("vmid", 0);
+        vm.type = QString::fromStdString(type_std);
+        vm.status = QString::fromStdString(item.value("status", "N/A"));
+        vm.node = QString::fromStdString(item.value("node", "N/A"));
+        vm.name = QString::fromStdString(item.value("name", "N/A"));
+        vm.pool = QString::fromStdString(item.value("pool", ""));
+        vm.tags = QString::fromStdString(item.value("tags", ""));
+        vm.cpu = item.value("cpu", 0.0);
+        vm.maxcpu = item.value("maxcpu", 0);
+        vm.mem = item.value("mem", qint64(0));
+        vm.maxmem = item.value("maxmem", qint64(0));
+        vm.disk = item.value("disk", qint64(0));
+        vm.maxdisk = item.value("maxdisk", qint64(0));
+        vm.netin = item.value("netin", qint64(0));
+        vm.netout = item.value("netout", qint64(0));
+        vm.diskread = item.value("diskread", qint64(0));
+        vm.diskwrite = item.value("diskwrite", qint64(0));
+        vm.uptime = item.value("uptime", qint64(0));
+        vm.isTemplate = item.value("template", 0) != 0;
+        output.push_back(vm);
+    }
+    return output.size();
+}
+
+QString VmResourceSaxParser::benchmark(int guests)
+{
+    const int NODES = 32;
+    const int ITERATIONS = 5;
+
+    // Deterministic pseudo-random cluster, shaped like a real response
+    json data = json::array();
+    quint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int i = 0; i < guests; ++i) {
+        const bool running = next() % 10 < 7;
+        const std::string type = next() % 4 == 0 ? "lxc" : "qemu";
+        const qint64 maxmem = qint64(1 + next() % 16) << 30;
+        data.push_back({
+            {"id", type + "/" + std::to_string(100 + i)}, {"type", type},
+            {"vmid", 100 + i}, {"name", "guest-" + std::to_string(i)}, {"node", "pve-node-" + std::to_string(next() % NODES)},
+            {"status", running ? "running" : "stopped"}, {"pool", "pool-" + std::to_string(next() % 8)},
+            {"tags", "web;prod"}, {"hastate", "started"}, {"template", 0},
+            {"cpu", running ? (next() % 1000) / 1000.0 : 0}, {"maxcpu", 1 + next() % 16},
+            {"mem", running ? static_cast<qint64>(maxmem * ((next() % 1000) / 1000.0)) : 0}, {"maxmem", maxmem},
+            {"disk", 0}, {"maxdisk", qint64(32) << 30}, {"uptime", running ? next() : 0},
+            {"netin", next()}, {"netout", next()}, {"diskread", next()}, {"diskwrite", next()}
+        });
+    }
+    const std::string body = json({{"data", data}}).dump();
+
+    QElapsedTimer timer;
+    int saxCount = 0;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        QVector<Vm> vms;
+        parse(body, vms);
+        saxCount = vms.size();
+    }
+    const qint64 saxUs = timer.nsecsElapsed() / 1000 / ITERATIONS;
+
+    int domCount = 0;
+    timer.restart();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        QVector<Vm> vms;
+        domCount = parseWithDom(body, vms);
+    }
+    const qint64 domUs = timer.nsecsElapsed() / 1000 / ITERATIONS;
+
+    return QString("SAX parse benchmark, %1 guests (%2 KiB): SAX %3 ms vs DOM %4 ms, %5/%6 records")
+        .arg(guests).arg(body.size() / 1024).arg(saxUs / 1000.0, 0, 'f', 1).arg(domUs / 1000.0, 0, 'f', 1)
+        .arg(saxCount).arg(domCount);
+}
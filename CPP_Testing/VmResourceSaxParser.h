@@ -0,0 +1,73 @@
+#ifndef VMRESOURCESAXPARSER_H
+#define VMRESOURCESAXPARSER_H
+
+#include <QVector>
+#include <string>
+#include "json.hpp"
+#include "ProxmoxApiManager.h" // For Vm struct
+
+// --- VmResourceSaxParser ---
+// Streaming (SAX) consumer for /cluster/resources?type=vm responses. Fills Vm records
+// directly from parser events, so no nlohmann::json DOM is ever built for the response.
+// Only qemu/lxc entries under the top-level "data" array are kept; folders are not
+// assigned here (see ProxmoxApiManager::handleVmListResponse).
+class VmResourceSaxParser
+{
+public:
+    using number_integer_t = json::number_integer_t;
+    using number_unsigned_t = json::number_unsigned_t;
+    using number_float_t = json::number_float_t;
+    using string_t = json::string_t;
+    using binary_t = json::binary_t;
+
+    explicit VmResourceSaxParser(QVector<Vm>& output) : vms(output) {}
+
+    // Parses 'body' and appends the records to 'output'. Returns false (and sets 'error') on malformed input.
+    static bool parse(const std::string& body, QVector<Vm>& output, std::string *error = nullptr);
+
+    // --- nlohmann SAX interface ---
+    bool null();
+    bool boolean(bool val);
+    bool number_integer(number_integer_t val);
+    bool number_unsigned(number_unsigned_t val);
+    bool number_float(number_float_t val, const string_t& s);
+    bool string(string_t& val);
+    bool binary(binary_t& val);
+    bool start_object(std::size_t elements);
+    bool key(string_t& val);
+    bool end_object();
+    bool start_array(std::size_t elements);
+    bool end_array();
+    bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex);
+
+    const std::string& errorMessage() const { return error_message; }
+
+    // Builds a synthetic /cluster/resources body with 'guests' entries and times this
+    // parser against the former DOM path (json::parse plus item.value lookups).
+    // Returns a summary line.
+    static QString benchmark(int guests);
+
+private:
+    enum class Field { None, Type, Vmid, Status, Node, Name, Pool, Tags, HaState, Cpu, MaxCpu, Mem, MaxMem,
+                       Disk, MaxDisk, NetIn, NetOut, DiskRead, DiskWrite, Uptime, Template };
+
+    // True while positioned directly inside one element of the "data" array
+    bool inRecord() const { return in_data_array && depth == 3; }
+    void beginRecord();
+    void endRecord();
+    void setIntegerField(long long val);
+    void setNumberField(double val);
+
+    QVector<Vm>& vms;
+    int depth = 0;                // 1 = top-level object, 2 = "data" array, 3 = resource object
+    bool data_key_pending = false;
+    bool in_data_array = false;
+    Field field = Field::None;
+
+    // Record being assembled
+    std::string type_std;
+    Vm current;
+    std::string error_message;
+};
+
+#endif // VMRESOURCESAXPARSER_H
@@ -1,6 +1,13 @@
 #include <QApplication>
 #include "ProxmoxClientWindow.h"
 #include <curl/curl.h> // Include curl initialization
+#include "CurlConnectionPool.h"
+#include "VmInventory.h"
+#include "VmResourceSaxParser.h"
+#include "VmModel.h"
+#include "FolderStore.h"
+#include "MetricsHistory.h"
+#include <QDebug>
 
 int main(int argc, char *argv[])
 {
@@ -10,9 +17,50 @@ int main(int argc, char *argv[])
     // Initialize the Qt Application
     QApplication a(argc, argv);
     
-    // Must register Vm struct for use in signals/slots across threads (if threading is used)
+    // Must register Vm struct for use in signals/slots across threads (the API manager has its own thread)
     qRegisterMetaType<Vm>("Vm");
     qRegisterMetaType<QVector<Vm>>("QVector<Vm>");
+    qRegisterMetaType<QVector<EndpointStatus>>("QVector<EndpointStatus>");
+    qRegisterMetaType<RrdSeries>("RrdSeries");
+
+    // Developer hook: PROXMOX_BENCH_SAX=<guests> logs the SAX vs DOM parse time of a synthetic
+    // /cluster/resources response
+    bool benchSaxOk = false;
+    int benchSax = qEnvironmentVariableIntValue("PROXMOX_BENCH_SAX", &benchSaxOk);
+    if (benchSaxOk && benchSax > 0) {
+        qInfo().noquote() << VmResourceSaxParser::benchmark(benchSax);
+    }
+    
+    // Developer hook: PROXMOX_BENCH_SCROLL=<items> logs the time to scroll a synthetic tree
+    // (e.g. 50000) through index()/parent()/data(), like a view does
+    bool benchScrollOk = false;
+    int benchScroll = qEnvironmentVariableIntValue("PROXMOX_BENCH_SCROLL", &benchScrollOk);
+    if (benchScrollOk && benchScroll > 0) {
+        qInfo().noquote() << VmModel::benchmark(benchScroll);
+    }
+    
+    // Developer hook: PROXMOX_BENCH_FOLDERS=<assignments> logs the startup cost of loading
+    // the folder mapping from legacy JSON versus the binary snapshot (e.g. 100000)
+    bool benchFoldersOk = false;
+    int benchFolders = qEnvironmentVariableIntValue("PROXMOX_BENCH_FOLDERS", &benchFoldersOk);
+    if (benchFoldersOk && benchFolders > 0) {
+        qInfo().noquote() << FolderStore::benchmark(benchFolders);
+    }
+    
+    // Developer hook: PROXMOX_BENCH_INVENTORY=<rows> logs a VmInventory scan benchmark at startup
+    bool benchRowsOk = false;
+    int benchRows = qEnvironmentVariableIntValue("PROXMOX_BENCH_INVENTORY", &benchRowsOk);
+    if (benchRowsOk && benchRows > 0) {
+        qInfo().noquote() << VmInventory::benchmark(benchRows);
+    }
+    
+    // Developer hook: PROXMOX_BENCH_HISTORY=<guests> logs the memory used by 4 hours of 5 s
+    // samples in MetricsHistory (10000 guests: a few seconds and ~200 MB while it runs)
+    bool benchGuestsOk = false;
+    int benchGuests = qEnvironmentVariableIntValue("PROXMOX_BENCH_HISTORY", &benchGuestsOk);
+    if (benchGuestsOk && benchGuests > 0) {
+        qInfo().noquote() << MetricsHistory::benchmark(benchGuests, 4, 5);
+    }
 
     // Create and show the main window
     ProxmoxClientWindow w;
@@ -21,7 +69,8 @@ int main(int argc, char *argv[])
     // Start the application event loop
     int result = a.exec();
     
-    // Cleanup libcurl
+    // Release pooled handles and the shared connection cache, then cleanup libcurl
+    CurlConnectionPool::instance().shutdown();
     curl_global_cleanup();
     
     return result;